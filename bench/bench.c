@@ -0,0 +1,825 @@
+// Micro-benchmarks for the genVec and String hot paths.
+//
+//     bench              CSV on stdout
+//     bench --json       JSON array on stdout
+//     bench --quick      10x fewer iterations (smoke test)
+//
+// Every container is created on a counting allocator, so allocs_per_op counts
+// the allocations and reallocations an operation actually triggers.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "gen_vector.h"
+#include "gen_vector_typed.h"
+#include "String.h"
+#include "GapBuffer.h"
+#include "hashmap.h"
+#include "conc_vector.h"
+#include "ring_buffer.h"
+#include "thread_pool.h"
+#include "soa_vector.h"
+#include "seg_vector.h"
+#include "bit_vector.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+typedef struct {
+    size_t allocs;      // alloc + realloc calls
+    size_t bytes;       // bytes requested by them
+} alloc_counter;
+
+static alloc_counter counter;
+static int json = 0;
+static int first_row = 1;
+static size_t scale = 1;
+
+static volatile size_t sink;   // keeps results alive past the optimizer
+
+
+static void* count_alloc(void* ctx, size_t size) {
+    alloc_counter* c = ctx;
+    c->allocs++;
+    c->bytes += size;
+    return malloc(size);
+}
+
+static void* count_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+    alloc_counter* c = ctx;
+    (void)old_size;
+    c->allocs++;
+    c->bytes += new_size;
+    return realloc(ptr, new_size);
+}
+
+static void count_free(void* ctx, void* ptr, size_t size) {
+    (void)ctx;
+    (void)size;
+    free(ptr);
+}
+
+static const genVec_allocator counting = { count_alloc, count_realloc, count_free, &counter };
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void counter_reset(void) {
+    counter.allocs = 0;
+    counter.bytes = 0;
+}
+
+static void report(const char* name, size_t elem_size, size_t ops, double elapsed_ns)
+{
+    double ns_per_op = elapsed_ns / (double)ops;
+    double allocs_per_op = (double)counter.allocs / (double)ops;
+    double bytes_per_op = (double)counter.bytes / (double)ops;
+
+    if (json) {
+        printf("%s\n  {\"benchmark\": \"%s\", \"elem_size\": %zu, \"ops\": %zu, "
+               "\"ns_per_op\": %.3f, \"allocs_per_op\": %.6f, \"bytes_per_op\": %.3f}",
+               first_row ? "[" : ",", name, elem_size, ops, ns_per_op, allocs_per_op, bytes_per_op);
+    } else {
+        if (first_row) { printf("benchmark,elem_size,ops,ns_per_op,allocs_per_op,bytes_per_op\n"); }
+        printf("%s,%zu,%zu,%.3f,%.6f,%.3f\n", name, elem_size, ops, ns_per_op, allocs_per_op, bytes_per_op);
+    }
+    first_row = 0;
+}
+
+
+// genVec benchmarks, run for each element size
+
+static void bench_vec(size_t elem_size)
+{
+    u8 elm[256];
+    memset(elm, 0xAB, sizeof(elm));
+
+    // ~16 MB of elements for the O(1) ops, far fewer for the O(n) ones
+    size_t n = ((size_t)16 << 20) / elem_size / scale;
+    if (n > ((size_t)1 << 20) / scale) { n = ((size_t)1 << 20) / scale; }
+    size_t n_shift = 4096 / scale;
+
+    double t;
+
+    counter_reset();
+    genVec* vec = genVec_init_alloc(0, elem_size, NULL, &counting);
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { genVec_push(vec, elm); }
+    report("vec_push", elem_size, n, now_ns() - t);
+
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { genVec_get(vec, i, elm); }
+    report("vec_get", elem_size, n, now_ns() - t);
+
+    counter_reset();
+    size_t acc = 0;
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { acc += *genVec_at_unchecked(vec, i); }
+    report("vec_at", elem_size, n, now_ns() - t);
+    sink = acc;
+
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { genVec_pop(vec, elm); }
+    report("vec_pop", elem_size, n, now_ns() - t);
+
+    // consumer loop polling an empty vec, only sets the error code
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { genVec_pop(vec, elm); }
+    report("vec_pop_empty", elem_size, n, now_ns() - t);
+    genVec_destroy(vec);
+
+    // uncontended cost of the atomic reserve + publish
+    counter_reset();
+    concVec* cv = concVec_create(elem_size, NULL);
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { concVec_push(cv, elm); }
+    report("cvec_push", elem_size, n, now_ns() - t);
+    concVec_destroy(cv);
+
+    counter_reset();
+    vec = genVec_init_alloc(0, elem_size, NULL, &counting);
+    t = now_ns();
+    for (size_t i = 0; i < n_shift; i++) { genVec_insert(vec, 0, elm); }
+    report("vec_insert_front", elem_size, n_shift, now_ns() - t);
+
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_shift; i++) { genVec_remove(vec, 0); }
+    report("vec_remove_front", elem_size, n_shift, now_ns() - t);
+    genVec_destroy(vec);
+}
+
+
+// String benchmarks
+
+static void bench_string(void)
+{
+    size_t n = ((size_t)1 << 22) / scale;
+    double t;
+
+    counter_reset();
+    String* str = string_create_alloc(&counting);
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { string_append_char(str, (char)('a' + (i % 26))); }
+    report("str_append_char", 1, n, now_ns() - t);
+    string_destroy(str);
+
+    counter_reset();
+    str = string_create_alloc(&counting);
+    t = now_ns();
+    for (size_t i = 0; i < n / 8; i++) { string_append_cstr(str, "token, "); }
+    report("str_append_cstr", 7, n / 8, now_ns() - t);
+
+    size_t n_fmt = n / 8;
+    counter_reset();
+    String* out = string_create_alloc(&counting);
+    t = now_ns();
+    for (size_t i = 0; i < n_fmt; i++) { string_appendf(out, "%zu,", i); }
+    report("str_appendf_int", 8, n_fmt, now_ns() - t);
+
+    string_clear(out);
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_fmt; i++) {
+        string_append_uint(out, i);
+        string_append_char(out, ',');
+    }
+    report("str_append_uint", 8, n_fmt, now_ns() - t);
+
+    string_clear(out);
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_fmt; i++) {
+        string_append_double(out, (double)i * 0.37, 3);
+        string_append_char(out, ',');
+    }
+    report("str_append_double", 8, n_fmt, now_ns() - t);
+    string_destroy(out);
+
+    // str is now a ~3.5 MB haystack, search for a needle that isn't in it
+    size_t n_find = 64 / scale + 1;
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_find; i++) { sink = (size_t)string_find_cstr(str, "tokens"); }
+    report("str_find_cstr_miss", string_len(str), n_find, now_ns() - t);
+
+    string_append_cstr(str, "needle");
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_find; i++) { sink = (size_t)string_find_cstr(str, "needle"); }
+    report("str_find_cstr_end", string_len(str), n_find, now_ns() - t);
+
+    size_t n_sub = n / 16;
+    size_t len = string_len(str);
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_sub; i++) {
+        String* sub = string_substr(str, (i * 7919) % (len - 16), 16);
+        sink = string_len(sub);
+        string_destroy(sub);
+    }
+    report("str_substr_16", 16, n_sub, now_ns() - t);
+
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_sub; i++) {
+        String* sub = string_substr(str, (i * 7919) % (len - 64), 64);
+        sink = string_len(sub);
+        string_destroy(sub);
+    }
+    report("str_substr_64", 64, n_sub, now_ns() - t);
+
+    string_destroy(str);
+
+    // fan out copies of a 4 KB value, plain vs shared (copy on write)
+    String* value = string_create_alloc(&counting);
+    for (size_t i = 0; i < 4096 / 8; i++) { string_append_cstr(value, "config, "); }
+
+    size_t n_copy = n / 64;
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_copy; i++) {
+        String* copy = string_from_string(value);
+        sink = string_len(copy);
+        string_destroy(copy);
+    }
+    report("str_copy_4k", 4096, n_copy, now_ns() - t);
+
+    string_share(value);
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_copy; i++) {
+        String* copy = string_from_string(value);
+        sink = string_len(copy);
+        string_destroy(copy);
+    }
+    report("str_copy_4k_shared", 4096, n_copy, now_ns() - t);
+    string_destroy(value);
+}
+
+
+// UTF-8: appends validate the new bytes as they go in, ascii vs mixed text in 4 KB
+// chunks, then the code point queries over the 4 MB result
+
+static void bench_utf8(void)
+{
+    size_t n = ((size_t)1 << 10) / scale;
+    double t;
+
+    char ascii[4096], mixed[4096];
+    static const char word[] = "gr\xC3\xB6\xC3\x9F" "e \xE6\x9D\xB1\xE4\xBA\xAC \xF0\x9F\x98\x80 ok, ";  // 24 bytes
+    for (size_t i = 0; i < sizeof(ascii); i++) { ascii[i] = (char)('a' + (i % 26)); }
+    for (size_t i = 0; i + sizeof(word) - 1 <= sizeof(mixed); i += sizeof(word) - 1) {
+        memcpy(mixed + i, word, sizeof(word) - 1);
+    }
+    size_t mixed_len = sizeof(mixed) / (sizeof(word) - 1) * (sizeof(word) - 1);
+
+    String* str = string_create_alloc(&counting);
+    string_reserve(str, n * sizeof(ascii));
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { string_append_n(str, ascii, sizeof(ascii)); }
+    report("utf8_append_4k_ascii", sizeof(ascii), n, now_ns() - t);
+    sink = (size_t)string_is_ascii(str);
+    string_destroy(str);
+
+    str = string_create_alloc(&counting);
+    string_reserve(str, n * mixed_len);
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { string_append_n(str, mixed, mixed_len); }
+    report("utf8_append_4k_mixed", mixed_len, n, now_ns() - t);
+    sink = (size_t)string_is_utf8(str);
+
+    size_t n_scan = 64 / scale + 1;
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_scan; i++) { sink = string_utf8_len(str); }
+    report("utf8_len_mixed", string_len(str), n_scan, now_ns() - t);
+
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_scan; i++) {
+        StringUtf8Iter it = string_utf8_iter(str);
+        uint32_t cp, acc = 0;
+        while (string_utf8_next(&it, &cp)) { acc += cp; }
+        sink = acc;
+    }
+    report("utf8_iter_mixed", string_len(str), n_scan, now_ns() - t);
+    string_destroy(str);
+}
+
+
+// cursor local edits in a 1 MB text, String shifts the tail, GapBuffer doesn't
+// (built on the default allocator, GapBuffer has no allocator hook)
+
+static void bench_edit(void)
+{
+    size_t text_len = (size_t)1 << 20;
+    size_t n = 4096 / scale;
+    double t;
+
+    String* str = string_create();
+    GapBuffer* gb = gapbuf_create();
+    for (size_t i = 0; i < text_len / 8; i++) {
+        string_append_cstr(str, "token, ");
+        gapbuf_append_cstr(gb, "token, ");
+    }
+    size_t cursor = string_len(str) / 2;
+
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { string_insert_char(str, cursor + i, 'x'); }
+    report("str_insert_mid", 1, n, now_ns() - t);
+
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { gapbuf_insert_char(gb, cursor + i, 'x'); }
+    report("gapbuf_insert_mid", 1, n, now_ns() - t);
+
+    size_t n_flat = 16 / scale + 1;
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n_flat; i++) {
+        String* flat = gapbuf_to_string(gb);
+        sink = string_len(flat);
+        string_destroy(flat);
+    }
+    report("gapbuf_to_string", gapbuf_len(gb), n_flat, now_ns() - t);
+
+    string_destroy(str);
+    gapbuf_destroy(gb);
+}
+
+
+// iteration helpers vs their pool versions over 16 MB of uint32_t
+
+static void algo_inc(u8* elm, void* ctx) { (void)ctx; (*(uint32_t*)elm)++; }
+static void algo_sum(u8* acc, const u8* elm, void* ctx) { (void)ctx; *(uint64_t*)acc += *(const uint32_t*)elm; }
+static void algo_add(u8* acc, const u8* other, void* ctx) { (void)ctx; *(uint64_t*)acc += *(const uint64_t*)other; }
+static int algo_odd(const u8* elm, void* ctx) { (void)ctx; return *(const uint32_t*)elm & 1; }
+
+static void bench_algo(void)
+{
+    size_t n = ((size_t)4 << 20) / scale;
+    double t;
+
+    genVec* vec = genVec_init(n, sizeof(uint32_t), NULL);
+    for (uint32_t i = 0; i < n; i++) { genVec_push(vec, (u8*)&i); }
+
+    t = now_ns();
+    genVec_for_each(vec, algo_inc, NULL);
+    report("algo_for_each", sizeof(uint32_t), n, now_ns() - t);
+
+    t = now_ns();
+    genVec_for_each_parallel(vec, algo_inc, NULL, 0);
+    report("algo_for_each_parallel", sizeof(uint32_t), n, now_ns() - t);
+
+    uint64_t acc = 0;
+    t = now_ns();
+    genVec_reduce(vec, (u8*)&acc, algo_sum, NULL);
+    report("algo_reduce", sizeof(uint32_t), n, now_ns() - t);
+
+    acc = 0;
+    t = now_ns();
+    genVec_reduce_parallel(vec, (u8*)&acc, sizeof(acc), algo_sum, algo_add, NULL, 0);
+    report("algo_reduce_parallel", sizeof(uint32_t), n, now_ns() - t);
+    sink = (size_t)acc;
+
+    genVec* copy = genVec_copy(vec);
+    t = now_ns();
+    genVec_filter(copy, algo_odd, NULL);
+    report("algo_filter", sizeof(uint32_t), n, now_ns() - t);
+    genVec_destroy(copy);
+
+    t = now_ns();
+    genVec_filter_parallel(vec, algo_odd, NULL, 0);
+    report("algo_filter_parallel", sizeof(uint32_t), n, now_ns() - t);
+
+    genVec_destroy(vec);
+}
+
+
+// fork/join overhead on the default pool: naive fib, one spawn per call
+
+typedef struct { unsigned n; uint64_t out; } fib_job;
+
+static void fib_task(void* arg)
+{
+    fib_job* job = arg;
+    if (job->n < 2) { job->out = job->n; return; }
+
+    fib_job a = { job->n - 1, 0 }, b = { job->n - 2, 0 };
+    taskGroup g;
+    task t;
+    task_group_init(&g);
+    task_spawn(tpool_default(), &g, &t, fib_task, &a);
+    fib_task(&b);
+    task_wait(tpool_default(), &g);
+    job->out = a.out + b.out;
+}
+
+static void bench_tasks(void)
+{
+    unsigned depth = scale > 1 ? 18 : 24;
+    fib_job job = { depth, 0 };
+
+    // every call with n >= 2 spawns once, fib(depth + 1) - 1 of them
+    uint64_t f0 = 0, f1 = 1;
+    for (unsigned i = 0; i <= depth; i++) { uint64_t f = f0 + f1; f0 = f1; f1 = f; }
+    size_t spawns = (size_t)f0 - 1;
+
+    double t = now_ns();
+    fib_task(&job);
+    report("task_spawn_wait", sizeof(task), spawns, now_ns() - t);
+    sink = (size_t)job.out;
+}
+
+// one field scan over 64 byte records: genVec of structs vs the soaVec column
+
+typedef struct { uint64_t id; double price; uint8_t rest[48]; } bench_rec;
+
+static void bench_soa(void)
+{
+    size_t n = ((size_t)1 << 20) / scale;
+    static const soaField fields[] = {
+        SOAVEC_FIELD(bench_rec, id), SOAVEC_FIELD(bench_rec, price), SOAVEC_FIELD(bench_rec, rest),
+    };
+
+    genVec* aos = genVec_init(n, sizeof(bench_rec), NULL);
+    soaVec* soa = soaVec_create(fields, 3, sizeof(bench_rec));
+    soaVec_reserve(soa, n);
+
+    bench_rec r;
+    memset(&r, 0, sizeof(r));
+    double t = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        r.id = i;
+        r.price = (double)i;
+        soaVec_push(soa, (u8*)&r);
+    }
+    report("soa_push", sizeof(bench_rec), n, now_ns() - t);
+    for (size_t i = 0; i < n; i++) {
+        r.id = i;
+        r.price = (double)i;
+        genVec_push(aos, (u8*)&r);
+    }
+
+    double sum = 0.0;
+    t = now_ns();
+    const bench_rec* recs = (const bench_rec*)genVec_data(aos);
+    for (size_t i = 0; i < n; i++) { sum += recs[i].price; }
+    report("aos_scan_field", sizeof(bench_rec), n, now_ns() - t);
+
+    t = now_ns();
+    const double* price = (const double*)soaVec_column(soa, 1);
+    for (size_t i = 0; i < n; i++) { sum += price[i]; }
+    report("soa_scan_field", sizeof(double), n, now_ns() - t);
+    sink = (size_t)sum;
+
+    soaVec_destroy(soa);
+    genVec_destroy(aos);
+}
+
+// growth without realloc copies: segVec push and indexed reads vs plain genVec
+
+static void bench_seg(void)
+{
+    size_t n = ((size_t)4 << 20) / scale;
+
+    genVec* vec = genVec_init(0, sizeof(uint64_t), NULL);
+    double t = now_ns();
+    for (uint64_t i = 0; i < n; i++) { genVec_push(vec, (u8*)&i); }
+    report("vec_push_grow", sizeof(uint64_t), n, now_ns() - t);
+
+    segVec* sv = segVec_create(sizeof(uint64_t), 0, NULL);
+    t = now_ns();
+    for (uint64_t i = 0; i < n; i++) { segVec_push(sv, (u8*)&i); }
+    report("seg_push", sizeof(uint64_t), n, now_ns() - t);
+
+    uint64_t sum = 0;
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { sum += *(uint64_t*)segVec_at_unchecked(sv, i); }
+    report("seg_at", sizeof(uint64_t), n, now_ns() - t);
+    sink = (size_t)sum;
+
+    segVec_destroy(sv);
+    genVec_destroy(vec);
+}
+
+// flags: a genVec of u8 per flag vs bitVec, and the whole word ops on bitVec
+
+static void bench_bits(void)
+{
+    size_t n = ((size_t)16 << 20) / scale;
+
+    u8 zero = 0;
+    genVec* bytes = genVec_init_val(n, &zero, sizeof(u8), NULL);
+    bitVec* bits = bitVec_create(n);
+    bitVec* other = bitVec_create(n);
+
+    double t = now_ns();
+    u8* flag = genVec_data(bytes);
+    for (size_t i = 0; i < n; i += 3) { flag[i] = 1; }
+    report("u8_flag_set", sizeof(u8), n / 3, now_ns() - t);
+
+    t = now_ns();
+    for (size_t i = 0; i < n; i += 3) { bitVec_set(bits, i); }
+    report("bit_set", sizeof(u8), n / 3, now_ns() - t);
+
+    size_t count = 0;
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { count += flag[i]; }
+    report("u8_flag_count", sizeof(u8), n, now_ns() - t);
+
+    t = now_ns();
+    count += bitVec_count(bits);
+    report("bit_count", sizeof(u8), n, now_ns() - t);
+
+    bitVec_set_all(other);
+    t = now_ns();
+    bitVec_and(other, bits);
+    report("bit_and", sizeof(u8), n, now_ns() - t);
+
+    t = now_ns();
+    for (size_t i = bitVec_find_first(other); i != BITVEC_NPOS; i = bitVec_find_next(other, i + 1)) { count++; }
+    report("bit_find_next", sizeof(u8), n, now_ns() - t);
+    sink = count;
+
+    bitVec_destroy(other);
+    bitVec_destroy(bits);
+    genVec_destroy(bytes);
+}
+
+// checkpoint/load through a tmpfile: genVec raw block vs the hand written get loop,
+// and line at a time reads into one reused String
+
+static void bench_io(void)
+{
+    size_t n = ((size_t)4 << 20) / scale;
+    double t;
+
+    genVec* vec = genVec_init(n, sizeof(uint32_t), NULL);
+    for (uint32_t i = 0; i < n; i++) { genVec_push(vec, (u8*)&i); }
+
+    FILE* f = tmpfile();
+    if (!f) { genVec_destroy(vec); return; }
+
+    counter_reset();
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        uint32_t x;
+        genVec_get(vec, i, (u8*)&x);
+        fwrite(&x, sizeof(x), 1, f);
+    }
+    fflush(f);
+    report("io_write_get_loop", sizeof(uint32_t), n, now_ns() - t);
+
+    rewind(f);
+    t = now_ns();
+    genVec_write(vec, f, NULL);
+    fflush(f);
+    report("io_vec_write", sizeof(uint32_t), n, now_ns() - t);
+
+    rewind(f);
+    t = now_ns();
+    genVec* back = genVec_read(f, sizeof(uint32_t), NULL, NULL);
+    report("io_vec_read", sizeof(uint32_t), n, now_ns() - t);
+    genVec_destroy(back);
+
+    // ~8 byte lines
+    rewind(f);
+    size_t n_lines = n / 4;
+    for (size_t i = 0; i < n_lines; i++) { fprintf(f, "%07zu\n", i); }
+    fflush(f);
+    rewind(f);
+
+    String* line = string_create();
+    t = now_ns();
+    size_t got = 0;
+    while (got < n_lines && string_read_line(line, f) == 0) { got++; }
+    report("io_str_read_line", 8, got ? got : 1, now_ns() - t);
+    string_destroy(line);
+
+    fclose(f);
+    genVec_destroy(vec);
+}
+
+
+// FIFO between stages: genVec push + remove(0) vs the rings, 1024 elms queued
+
+static void bench_fifo(void)
+{
+    size_t depth = 1024;
+    size_t n = ((size_t)1 << 20) / scale;
+    uint64_t x = 0;
+    double t;
+
+    genVec* vec = genVec_init(depth + 1, sizeof(uint64_t), NULL);
+    for (size_t i = 0; i < depth; i++) { genVec_push(vec, (u8*)&x); }
+    size_t n_vec = n / 64;
+    t = now_ns();
+    for (size_t i = 0; i < n_vec; i++) {
+        genVec_push(vec, (u8*)&x);
+        genVec_front(vec, (u8*)&x);
+        genVec_remove(vec, 0);
+    }
+    report("fifo_genvec", 8, n_vec, now_ns() - t);
+    genVec_destroy(vec);
+
+    spscRing* spsc = spscRing_create(depth * 2, sizeof(uint64_t), NULL);
+    for (size_t i = 0; i < depth; i++) { spscRing_push(spsc, (u8*)&x); }
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        spscRing_push(spsc, (u8*)&x);
+        spscRing_pop(spsc, (u8*)&x);
+    }
+    report("fifo_spsc", 8, n, now_ns() - t);
+
+    uint64_t batch[32] = { 0 };
+    t = now_ns();
+    for (size_t i = 0; i < n / 32; i++) {
+        spscRing_push_n(spsc, (u8*)batch, 32);
+        spscRing_pop_n(spsc, (u8*)batch, 32);
+    }
+    report("fifo_spsc_batch32", 8, n, now_ns() - t);
+    spscRing_destroy(spsc);
+
+    mpmcRing* mpmc = mpmcRing_create(depth * 2, sizeof(uint64_t), NULL);
+    for (size_t i = 0; i < depth; i++) { mpmcRing_push(mpmc, (u8*)&x); }
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        mpmcRing_push(mpmc, (u8*)&x);
+        mpmcRing_pop(mpmc, (u8*)&x);
+    }
+    report("fifo_mpmc", 8, n, now_ns() - t);
+    mpmcRing_destroy(mpmc);
+    sink = (size_t)x;
+}
+
+
+// sort benchmarks on 16 byte records keyed by a u64
+
+typedef struct {
+    uint64_t key;
+    uint64_t payload;
+} sort_rec;
+
+static int sort_rec_cmp(const u8* a, const u8* b) {
+    uint64_t x = ((const sort_rec*)a)->key, y = ((const sort_rec*)b)->key;
+    return (x > y) - (x < y);
+}
+
+static inline int sort_rec_less(const sort_rec* a, const sort_rec* b) {
+    return a->key < b->key;
+}
+
+GENVEC_DECLARE_SORT(sort_rec, RecVec, sort_rec_less)
+
+static genVec* sort_input(size_t n) {
+    genVec* vec = genVec_init(n, sizeof(sort_rec), NULL);
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = 0; i < n; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;   // xorshift, same input every run
+        sort_rec r = { x, i };
+        genVec_push(vec, (u8*)&r);
+    }
+    return vec;
+}
+
+static void bench_sort(void)
+{
+    size_t n = ((size_t)1 << 21) / scale;
+    genVec* vec;
+    double t;
+
+    vec = sort_input(n);
+    counter_reset();
+    t = now_ns();
+    qsort(vec->data, n, sizeof(sort_rec), (int (*)(const void*, const void*))sort_rec_cmp);
+    report("sort_qsort", sizeof(sort_rec), n, now_ns() - t);
+    genVec_destroy(vec);
+
+    vec = sort_input(n);
+    t = now_ns();
+    genVec_sort(vec, sort_rec_cmp);
+    report("sort_genvec", sizeof(sort_rec), n, now_ns() - t);
+    genVec_destroy(vec);
+
+    vec = sort_input(n);
+    t = now_ns();
+    genVec_stable_sort(vec, sort_rec_cmp);
+    report("sort_stable", sizeof(sort_rec), n, now_ns() - t);
+    genVec_destroy(vec);
+
+    vec = sort_input(n);
+    t = now_ns();
+    RecVec_sort(vec);
+    report("sort_typed", sizeof(sort_rec), n, now_ns() - t);
+    genVec_destroy(vec);
+
+    vec = sort_input(n);
+    t = now_ns();
+    genVec_sort_parallel(vec, sort_rec_cmp, 0);
+    report("sort_parallel", sizeof(sort_rec), n, now_ns() - t);
+
+    sort_rec key = *(sort_rec*)genVec_at(vec, n / 3);
+    size_t acc = 0;
+    t = now_ns();
+    for (size_t i = 0; i < n; i++) { acc += genVec_lower_bound(vec, (u8*)&key, sort_rec_cmp); }
+    report("vec_lower_bound", sizeof(sort_rec), n, now_ns() - t);
+    sink = acc;
+    genVec_destroy(vec);
+}
+
+
+// hashmap benchmarks, u64 keys and String* keys (cached hash)
+
+static void bench_map(void)
+{
+    size_t n = ((size_t)1 << 20) / scale;
+    double t;
+
+    HashMap* map = hashmap_create(sizeof(uint64_t), sizeof(uint64_t), NULL, NULL, NULL, NULL);
+    t = now_ns();
+    for (uint64_t i = 0; i < n; i++) { hashmap_insert(map, (u8*)&i, (u8*)&i); }
+    report("map_insert_u64", 8, n, now_ns() - t);
+
+    size_t acc = 0;
+    t = now_ns();
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t key = (i * 2654435761u) % n;
+        acc += *(uint64_t*)hashmap_get(map, (u8*)&key);
+    }
+    report("map_get_u64", 8, n, now_ns() - t);
+
+    t = now_ns();
+    for (uint64_t i = n; i < 2 * n; i++) { acc += (size_t)hashmap_contains(map, (u8*)&i); }
+    report("map_get_u64_miss", 8, n, now_ns() - t);
+    sink = acc;
+    hashmap_destroy(map);
+
+    // keys are built up front so only the map work is timed
+    size_t n_str = n / 4;
+    String** keys = malloc(n_str * sizeof(String*));
+    for (size_t i = 0; i < n_str; i++) {
+        keys[i] = string_create();
+        string_appendf(keys[i], "key:%zu:suffix", i);
+    }
+
+    map = hashmap_create(sizeof(String*), sizeof(size_t), hashmap_string_hash, hashmap_string_eq, NULL, NULL);
+    t = now_ns();
+    for (size_t i = 0; i < n_str; i++) { hashmap_insert(map, (u8*)&keys[i], (u8*)&i); }
+    report("map_insert_str", 16, n_str, now_ns() - t);
+
+    t = now_ns();
+    for (size_t i = 0; i < n_str; i++) { acc += *(size_t*)hashmap_get(map, (u8*)&keys[(i * 7919) % n_str]); }
+    report("map_get_str_cached", 16, n_str, now_ns() - t);
+    sink = acc;
+
+    hashmap_destroy(map);
+    for (size_t i = 0; i < n_str; i++) { string_destroy(keys[i]); }
+    free(keys);
+}
+
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) { json = 1; }
+        else if (strcmp(argv[i], "--quick") == 0) { scale = 10; }
+        else {
+            fprintf(stderr, "usage: %s [--json] [--quick]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    static const size_t sizes[] = { 1, 4, 16, 64, 256 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench_vec(sizes[i]);
+    }
+    bench_string();
+    bench_utf8();
+    bench_edit();
+    bench_map();
+    bench_sort();
+    bench_fifo();
+    bench_algo();
+    bench_tasks();
+    bench_soa();
+    bench_seg();
+    bench_bits();
+    bench_io();
+
+    if (json) { printf("\n]\n"); }
+    return 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "gen_vector.h"
+#include "String.h"
+#include "StringView.h"
+#include <stddef.h>
+
+
+// Text buffer for editor style workloads. The chars live in one genVec with
+// a gap at the last edit position:
+//
+//     [ text before | ...gap... | text after ]
+//
+// Edits at the gap are O(1), moving the gap costs only the distance moved,
+// so thousands of edits around a cursor don't memmove the whole tail each time.
+typedef struct {
+    genVec buffer;      // chars + gap, size is always the full buffer extent
+    size_t gap_start;   // first byte of the gap (the cursor)
+    size_t gap_end;     // one past the last byte of the gap
+} GapBuffer;
+
+
+// Construction/Destruction
+GapBuffer* gapbuf_create(void);
+GapBuffer* gapbuf_from_cstr(const char* cstr);
+void gapbuf_destroy(GapBuffer* gb);
+
+// Basic properties
+static inline size_t gapbuf_len(const GapBuffer* gb) {
+    return gb ? gb->buffer.size - (gb->gap_end - gb->gap_start) : 0;
+}
+static inline int gapbuf_empty(const GapBuffer* gb) {
+    return gapbuf_len(gb) == 0;
+}
+
+// Modification (i is a char index in the text, gap excluded)
+void gapbuf_append_cstr(GapBuffer* gb, const char* cstr);
+void gapbuf_append_char(GapBuffer* gb, char c);
+void gapbuf_insert_char(GapBuffer* gb, size_t i, char c);
+void gapbuf_insert_cstr(GapBuffer* gb, size_t i, const char* cstr);
+void gapbuf_insert_n(GapBuffer* gb, size_t i, const char* data, size_t len); // data may be a view of gb's own text
+void gapbuf_remove_char(GapBuffer* gb, size_t i);
+void gapbuf_remove_range(GapBuffer* gb, size_t i, size_t n);
+void gapbuf_clear(GapBuffer* gb);
+
+// Access
+char gapbuf_at(const GapBuffer* gb, size_t i);
+void gapbuf_set_char(GapBuffer* gb, size_t i, char c);
+
+// the text as two views (before and after the gap), no copying
+void gapbuf_views(const GapBuffer* gb, StringView* before, StringView* after);
+
+// Flatten into a new String (one exact size allocation + two copies)
+String* gapbuf_to_string(const GapBuffer* gb);
+
@@ -1,27 +1,50 @@
 #pragma once
 
 #include "gen_vector.h"
+#include "StringView.h"
+#include <stdarg.h>
 #include <stddef.h>
 
 
+#if defined(__GNUC__)
+#define STRING_PRINTF_FMT(fmt_idx, args_idx) __attribute__((format(printf, fmt_idx, args_idx)))
+#else
+#define STRING_PRINTF_FMT(fmt_idx, args_idx)
+#endif
+
+// Strings up to STRING_SSO_SIZE - 1 chars are stored inline, with no heap allocation
+#define STRING_SSO_SIZE 24
+
+// buffer starts out on sso and moves to the heap once the string outgrows it,
+// so a String must not be copied by value (use string_from_string)
 typedef struct {
-    genVec* buffer;  // Vector of chars - the actual string data
+    genVec buffer;                // Vector of chars - the actual string data
+    char sso[STRING_SSO_SIZE];    // inline storage for short strings
+    uint64_t hash;                // cached string_hash, 0 until computed or after a mutation
+    uint32_t text;                // cached encoding state for the UTF-8 queries
 } String;
 
 // Construction/Destruction
 String* string_create(void);
+String* string_create_alloc(const genVec_allocator* alloc); // struct and buffer come from alloc
 void string_create_onstack(String* str, const char* cstr);
 String* string_from_cstr(const char* cstr);
 String* string_from_string(const String* other);
+String* string_from_view(StringView sv);
 void string_reserve(String* str, size_t capacity); 
 void string_destroy(String* str);
 void string_destroy_fromstk(String* str);
 
+// Copy on write - after string_share, string_from_string(str) is O(1) and the copies
+// share one refcounted buffer until a mutation gives that string its own copy.
+// Strings short enough for sso stay inline (their copies are cheap anyway).
+int string_share(String* str);
+
 // Basic properties
 static inline size_t string_len(const String* str) {
-    if (!str || !str->buffer) { return 0; }
+    if (!str) { return 0; }
 
-    size_t size = genVec_size(str->buffer);
+    size_t size = str->buffer.size;
     // Subtract 1 for null terminator if present
     return (size > 0) ? size - 1 : 0;
 }
@@ -30,10 +53,27 @@ static inline int string_empty(const String* str) {
 }
 const char* string_to_cstr(const String* str);
 
+// Ownership transfer
+void string_move(String* dst, String* src);          // dst takes src's contents, src is left empty
+char* string_release_cstr(String* str, size_t* len); // caller free()s it, str is left empty
+
 // Modification
 void string_append_cstr(String* str, const char* cstr);
+void string_append_n(String* str, const char* data, size_t len); // no strlen, data needn't be null terminated
 void string_append_string(String* str, const String* other);
+void string_append_view(String* str, StringView sv);
 void string_append_char(String* str, char c);
+
+// Formatted append, written straight into the spare capacity (grows once if it doesn't fit).
+// The arguments must not point into str itself.
+void string_appendf(String* str, const char* fmt, ...) STRING_PRINTF_FMT(2, 3);
+void string_vappendf(String* str, const char* fmt, va_list args);
+
+// Number appenders, no format parsing
+void string_append_int(String* str, long long v);
+void string_append_uint(String* str, unsigned long long v);
+// fixed point with decimals 0..9, exact ties round away from zero (printf rounds them to even)
+void string_append_double(String* str, double v, int decimals);
 void string_insert_char(String* str, size_t i, char c);
 void string_insert_cstr(String* str, size_t i, const char* cstr);
 void string_insert_string(String* str, size_t i, String* other);
@@ -49,6 +89,10 @@ int string_compare(const String* str1, const String* str2);
 int string_equals(const String* str1, const String* str2);
 int string_equals_cstr(const String* str, const char* cstr);
 
+// Hashing - string_hash is cached until the next mutation (default seed only)
+uint64_t string_hash(const String* str);
+uint64_t string_hash_seed(const String* str, uint64_t seed);
+
 // Search
 int string_find_char(const String* str, char c);
 int string_find_cstr(const String* str, const char* substr);
@@ -56,7 +100,56 @@ int string_find_cstr(const String* str, const char* substr);
 // Substring
 String* string_substr(const String* str, size_t start, size_t length);
 
-// I/O
+// UTF-8 - the byte API above never looks at the encoding, these read the bytes as
+// UTF-8 text. Whether the string is valid (or all ascii) is tracked as it is built:
+// appends check just the new bytes (SIMD), so these are O(1) most of the time.
+int string_is_ascii(const String* str);
+int string_is_utf8(const String* str);          // ascii is valid UTF-8 too
+size_t string_utf8_len(const String* str);      // code points, a malformed byte counts as one
+// start_cp and n_cp in code points, so no character gets cut. NULL if start_cp is past the end
+String* string_utf8_substr(const String* str, size_t start_cp, size_t n_cp);
+
+// Code point iterator, malformed bytes come back as U+FFFD one byte at a time
+//
+//     StringUtf8Iter it = string_utf8_iter(str);
+//     uint32_t cp;
+//     while (string_utf8_next(&it, &cp)) { ... }   // it.pos is the byte offset of the next one
+typedef struct {
+    const char* ptr;
+    size_t len;
+    size_t pos;
+} StringUtf8Iter;
+
+int string_utf8_next_multi(StringUtf8Iter* it, uint32_t* cp);   // the non-ascii half of string_utf8_next
+
+static inline StringUtf8Iter string_utf8_iter(const String* str) {
+    StringUtf8Iter it = { str ? (const char*)str->buffer.data : "", string_len(str), 0 };
+    return it;
+}
+
+// next code point into cp, 0 at the end
+static inline int string_utf8_next(StringUtf8Iter* it, uint32_t* cp) {
+    if (it->pos >= it->len) { return 0; }
+
+    unsigned char c = (unsigned char)it->ptr[it->pos];
+    if (c < 0x80) {
+        *cp = c;
+        it->pos++;
+        return 1;
+    }
+    return string_utf8_next_multi(it, cp);
+}
+
+// Views (no allocation, valid until str is modified)
+static inline StringView string_view_of(const String* str) {
+    return str ? sv_make((const char*)str->buffer.data, string_len(str)) : sv_make(NULL, 0);
+}
+
+// I/O - reads go straight into str's buffer (replacing its contents), 0 on success
 void string_print(const String* str);
+// next line without its '\n', -1 at end of file with nothing read (GENVEC_ERR_EMPTY, never printed)
+int string_read_line(String* str, FILE* f);
+int string_read_file(String* str, const char* path);   // whole file, one allocation for regular files
+int string_write(const String* str, FILE* f);
 
 
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "String.h"
+#include "StringView.h"
+#include "allocator.h"
+#include "hashmap.h"
+#include <stddef.h>
+
+
+// Interning pool: every distinct value is stored once, in one arena, and
+// handed out as a const String*. Interning equal contents always gives back
+// the same pointer, so interned strings compare with ==.
+//
+// Interned strings live until strpool_destroy and must never be modified
+// (they are not heap strings, string_destroy on them is a bug).
+typedef struct {
+    Arena* arena;       // String headers + chars of every interned value
+    HashMap* index;     // set of const String*, by contents (cached hashes)
+} StringPool;
+
+
+// Construction/Destruction
+StringPool* strpool_create(void);
+void strpool_destroy(StringPool* pool);
+
+static inline size_t strpool_size(const StringPool* pool) {
+    return pool ? hashmap_size(pool->index) : 0;
+}
+
+// Interning - returns the pooled copy, adding it on first sight (NULL on error)
+const String* strpool_intern_view(StringPool* pool, StringView sv);
+const String* strpool_intern_cstr(StringPool* pool, const char* cstr);
+const String* strpool_intern(StringPool* pool, const String* str);
+
+// Lookup without inserting, NULL if the value was never interned
+const String* strpool_find_view(const StringPool* pool, StringView sv);
+const String* strpool_find_cstr(const StringPool* pool, const char* cstr);
+
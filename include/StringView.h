@@ -0,0 +1,44 @@
+#pragma once
+
+#include "genvec_error.h"
+
+#include <stddef.h>
+
+
+// Non owning view of a char range - never allocates, never null terminated.
+// A view of a String is only valid until that String is modified or destroyed.
+typedef struct {
+    const char* ptr;
+    size_t len;
+} StringView;
+
+
+static inline StringView sv_make(const char* ptr, size_t len) {
+    StringView sv = { ptr, len };
+    return sv;
+}
+
+StringView sv_from_cstr(const char* cstr);
+
+// Slicing (clamped to the view, never out of bounds)
+StringView sv_substr(StringView sv, size_t start, size_t len);
+StringView sv_trim(StringView sv);          // ascii whitespace on both ends
+StringView sv_trim_left(StringView sv);
+StringView sv_trim_right(StringView sv);
+
+// Search (index or -1)
+int sv_find_char(StringView sv, char c);
+int sv_find(StringView sv, StringView needle);
+
+// Comparison
+int sv_equals(StringView a, StringView b);
+int sv_equals_cstr(StringView sv, const char* cstr);
+int sv_starts_with(StringView sv, StringView prefix);
+
+// Tokenizing: pulls the next token up to delim off the front of rest.
+// Returns 0 once rest is used up, "a,,b" gives "a", "", "b".
+//
+//     StringView rest = sv_from_cstr("a,b,c"), tok;
+//     while (sv_split_next(&rest, ',', &tok)) { ... }
+int sv_split_next(StringView* rest, char delim, StringView* token);
+
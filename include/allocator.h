@@ -0,0 +1,56 @@
+#pragma once
+
+#include "gen_vector.h"
+#include <stddef.h>
+
+
+// Ready made genVec_allocators. Hand arena_allocator() / pool_allocator() to
+// genVec_init_alloc or string_create_alloc, everything allocated from them
+// goes away together on reset/destroy.
+
+#define ARENA_ALIGN 16
+#define ARENA_DEFAULT_BLOCK (64 * 1024)
+
+
+typedef struct arena_block arena_block;
+
+// bump allocator - free is a no-op (except for the last allocation),
+// memory comes back all at once with arena_reset
+typedef struct {
+    arena_block* first;          // blocks in order, kept around across resets
+    arena_block* head;           // block we are currently bumping in
+    size_t block_size;           // size of new blocks
+    genVec_allocator allocator;  // vtable pointing back at this arena
+} Arena;
+
+Arena* arena_create(size_t block_size);   // 0 for ARENA_DEFAULT_BLOCK
+void arena_destroy(Arena* arena);
+void arena_reset(Arena* arena);           // O(1), blocks are reused
+void* arena_alloc(Arena* arena, size_t size);
+const genVec_allocator* arena_allocator(Arena* arena);
+
+
+typedef struct pool_chunk pool_chunk;
+typedef struct pool_big pool_big;
+
+// fixed size block allocator - freed blocks are reused by the next alloc.
+// Requests bigger than block_size (through pool_allocator) are malloc'd on the
+// side and kept on a list, so reset/destroy free them too
+typedef struct {
+    size_t block_size;           // rounded up to ARENA_ALIGN
+    size_t blocks_per_chunk;
+    void* free_list;             // freed blocks, linked through their first bytes
+    pool_chunk* first;           // chunks in order, kept around across resets
+    pool_chunk* head;            // chunk we are currently carving blocks from
+    size_t head_used;            // blocks handed out from head
+    pool_big* big;               // live oversized blocks
+    genVec_allocator allocator;  // vtable pointing back at this pool
+} Pool;
+
+Pool* pool_create(size_t block_size, size_t blocks_per_chunk);
+void pool_destroy(Pool* pool);
+void pool_reset(Pool* pool);              // chunks are reused, O(1) plus a free per oversized block
+void* pool_alloc(Pool* pool);
+void pool_free(Pool* pool, void* block);
+const genVec_allocator* pool_allocator(Pool* pool);
+
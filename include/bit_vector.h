@@ -0,0 +1,86 @@
+#pragma once
+
+#include "gen_vector.h"
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Packed bit vector: one bit per flag in 64 bit words, instead of a byte per
+// flag in a genVec of u8.
+//
+//     bitVec* visited = bitVec_create(n_nodes);
+//     bitVec_set(visited, v);
+//     if (!bitVec_test(visited, w)) { ... }
+//
+//     bitVec_and(mask, other_mask);                  // whole words at a time (SIMD)
+//     for (size_t i = bitVec_find_first(mask); i != BITVEC_NPOS; i = bitVec_find_next(mask, i + 1)) { ... }
+//
+// The words are a genVec of uint64_t, bit i is bit (i % 64) of word i / 64.
+// Bits past n_bits in the last word are always 0, so counts and bulk ops never
+// see garbage. The single bit accessors are inline and only assert bounds
+// (debug builds), the bulk ops need both vectors to have the same n_bits.
+
+#define BITVEC_NPOS ((size_t)-1)
+
+
+typedef struct {
+    genVec words;       // uint64_t, (n_bits + 63) / 64 of them
+    size_t n_bits;
+} bitVec;
+
+
+// Construction/Destruction - every bit starts out 0
+bitVec* bitVec_create(size_t n_bits);
+bitVec* bitVec_copy(const bitVec* src);
+void bitVec_destroy(bitVec* bv);
+
+int bitVec_resize(bitVec* bv, size_t n_bits);   // new bits are 0
+int bitVec_push(bitVec* bv, int bit);
+void bitVec_set_all(bitVec* bv);
+void bitVec_clear_all(bitVec* bv);
+
+// Bulk ops, dst = dst op src (0 on success, -1 if the sizes differ)
+int bitVec_and(bitVec* dst, const bitVec* src);
+int bitVec_or(bitVec* dst, const bitVec* src);
+int bitVec_xor(bitVec* dst, const bitVec* src);
+int bitVec_andnot(bitVec* dst, const bitVec* src);  // dst & ~src
+void bitVec_not(bitVec* bv);
+
+// Queries
+size_t bitVec_count(const bitVec* bv);                      // set bits (popcount)
+size_t bitVec_find_first(const bitVec* bv);                 // BITVEC_NPOS if none
+size_t bitVec_find_next(const bitVec* bv, size_t from);     // first set bit >= from
+size_t bitVec_find_next_zero(const bitVec* bv, size_t from);
+
+static inline size_t bitVec_size(const bitVec* bv) {
+    return bv ? bv->n_bits : 0;
+}
+
+static inline uint64_t* bitVec_words(const bitVec* bv) {
+    return bv ? (uint64_t*)bv->words.data : NULL;
+}
+
+static inline int bitVec_test(const bitVec* bv, size_t i) {
+    assert(bv && i < bv->n_bits);
+    return (int)((bitVec_words(bv)[i >> 6] >> (i & 63)) & 1u);
+}
+
+static inline void bitVec_set(bitVec* bv, size_t i) {
+    assert(bv && i < bv->n_bits);
+    bitVec_words(bv)[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+static inline void bitVec_clear(bitVec* bv, size_t i) {
+    assert(bv && i < bv->n_bits);
+    bitVec_words(bv)[i >> 6] &= ~((uint64_t)1 << (i & 63));
+}
+
+static inline void bitVec_flip(bitVec* bv, size_t i) {
+    assert(bv && i < bv->n_bits);
+    bitVec_words(bv)[i >> 6] ^= (uint64_t)1 << (i & 63);
+}
+
+static inline void bitVec_assign(bitVec* bv, size_t i, int bit) {
+    if (bit) { bitVec_set(bv, i); }
+    else     { bitVec_clear(bv, i); }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "gen_vector.h"
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Append only vector that many threads can push into at once without a lock.
+//
+// Elements live in segments of geometrically growing size (segment k holds
+// CONCVEC_FIRST_SEG << k elms), so nothing is ever reallocated and element
+// addresses are stable. push reserves a slot with one atomic fetch-add, copies
+// the element in and publishes it; get/at on a published index is wait-free.
+//
+// create/destroy/to_genVec must not race with pushes.
+
+#define CONCVEC_FIRST_SEG_BITS 6
+#define CONCVEC_FIRST_SEG ((size_t)1 << CONCVEC_FIRST_SEG_BITS)
+#define CONCVEC_MAX_SEGS 48
+
+#define CONCVEC_FULL SIZE_MAX   // returned by push when no slot could be made
+
+
+typedef struct {
+    size_t reserved;                                // slots handed out so far (atomic)
+    char pad[64 - sizeof(size_t)];                  // keep the hot counter on its own cache line
+    u8* segs[CONCVEC_MAX_SEGS];                     // elms, then one ready byte per elm
+    size_t data_size;
+    genVec_delete_fn del_fn;
+} concVec;
+
+
+// Construction/Destruction
+concVec* concVec_create(size_t data_size, genVec_delete_fn del_fn);
+void concVec_destroy(concVec* cv);    // del_fn runs on every published elm
+
+// Thread safe - returns the index the elm went to, or CONCVEC_FULL
+size_t concVec_push(concVec* cv, const u8* data);
+
+// Thread safe, wait-free. Unpublished indices (reserved but still being
+// written, or never reserved) give NULL / -1.
+u8* concVec_at(const concVec* cv, size_t i);
+int concVec_get(const concVec* cv, size_t i, u8* out);
+
+// slots reserved so far, the last few may not be published yet
+size_t concVec_size(const concVec* cv);
+
+// copy everything into a plain genVec once the pushers are done
+// (del_fn is not passed on, the elms are still owned by cv)
+genVec* concVec_to_genVec(const concVec* cv);
+
@@ -1,7 +1,12 @@
 #pragma once
 
+#include "genvec_error.h"
+#include "genvec_stats.h"
+
+#include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 
 typedef uint8_t u8;
@@ -10,6 +15,44 @@ typedef uint8_t u8;
 typedef int (*genVec_compare_fn)(const u8* a, const u8* b);
 typedef void (*genVec_print_fn)(const u8* elm);
 typedef void (*genVec_delete_fn)(u8* elm);
+// serialization hooks for elms that own memory, 0 on success
+typedef int (*genVec_write_fn)(const u8* elm, FILE* f);
+typedef int (*genVec_read_fn)(u8* elm, FILE* f);     // fills all data_size bytes of elm
+// iteration callbacks, ctx is passed through untouched
+typedef void (*genVec_visit_fn)(u8* elm, void* ctx);
+typedef void (*genVec_map_fn)(const u8* in, u8* out, void* ctx);     // fills all of out
+typedef int (*genVec_pred_fn)(const u8* elm, void* ctx);
+typedef void (*genVec_reduce_fn)(u8* acc, const u8* elm, void* ctx);  // acc = acc op elm
+typedef void (*genVec_combine_fn)(u8* acc, const u8* other, void* ctx); // acc = acc op other
+
+
+// pluggable allocator, sizes are passed back on realloc/free so
+// arenas and pools don't need to keep per block headers
+typedef struct {
+    void* (*alloc)(void* ctx, size_t size);
+    void* (*realloc)(void* ctx, void* ptr, size_t old_size, size_t new_size);
+    void  (*free)(void* ctx, void* ptr, size_t size);
+    void* ctx;
+} genVec_allocator;
+
+
+// growth/shrink behaviour, shared by pointer so it must outlive the vecs using it
+typedef struct {
+    double growth;          // capacity multiplier when full (finite, > 1)
+    size_t min_capacity;    // first allocation size, never shrink below this
+    int shrink;             // 0 turns off automatic shrinking in pop/remove
+    double shrink_at;       // shrink once size <= capacity * shrink_at
+    double shrink_by;       // to capacity * shrink_by (0 <= shrink_at < shrink_by <= 1)
+} genVec_policy;
+
+extern const genVec_policy genVec_default_policy;   // 1.5x, min 4, shrink at 25% to 50%
+
+
+//flags
+#define GENVEC_EXTERNAL 0x1u    // data is a caller provided buffer, not owned by the vec
+#define GENVEC_SHARED   0x2u    // data is a refcounted buffer shared with copies (copy on write)
+#define GENVEC_MAPPED   0x4u    // data lives in a mapped file (mmapVec), alloc only resizes that file
+#define GENVEC_FIXED    0x8u    // capacity can't change (read only mmapVec), growing fails with GENVEC_ERR_INVALID
 
 
 typedef struct {
@@ -18,29 +61,127 @@ typedef struct {
     size_t capacity;
     size_t data_size;
     genVec_delete_fn del_fn;
-} __attribute__((aligned(64))) genVec;
+    const genVec_allocator* alloc;  // NULL for malloc/realloc/free
+    const genVec_policy* policy;    // NULL for genVec_default_policy
+    uint32_t flags;
+#ifdef GENVEC_STATS
+    genVec_stats stats;             // this vec's counters, see genvec_stats.h
+#endif
+} genVec;
 
 
 //memory management
 genVec* genVec_init(size_t n, size_t data_size, genVec_delete_fn del_fn);
 genVec* genVec_init_val(size_t n, const u8* val, size_t data_size, genVec_delete_fn del_fn);
 void genVec_destroy(genVec* vec);
+
+// header and data both come from alloc (which must outlive the vec)
+genVec* genVec_init_alloc(size_t n, size_t data_size, genVec_delete_fn del_fn, const genVec_allocator* alloc);
+// only for in place vecs that don't own heap data yet (capacity 0 or an external buffer)
+int genVec_set_allocator(genVec* vec, const genVec_allocator* alloc);
+
+// in place init for vecs embedded in other structs or on the stack (no header allocation)
+int genVec_init_inplace(genVec* vec, size_t n, size_t data_size, genVec_delete_fn del_fn);
+// start on a caller owned buffer of buf_cap elements, moves to the heap once it overflows
+int genVec_init_buffer(genVec* vec, u8* buf, size_t buf_cap, size_t data_size, genVec_delete_fn del_fn);
+// release the data of an in place vec (vec itself is left as a valid empty vector)
+void genVec_deinit(genVec* vec);
 void genVec_clear(genVec* vec);
-void genVec_reserve(genVec* vec, size_t new_capacity);
+int genVec_reserve(genVec* vec, size_t new_capacity);
+void genVec_shrink_to_fit(genVec* vec);
+// NULL restores the default, set it right after init to control the first allocation
+int genVec_set_policy(genVec* vec, const genVec_policy* policy);
 
-//operations
-void genVec_push(genVec* vec, const u8* data);
+//operations (int returns: 0 on success, -1 on failure, genVec_last_error() says why;
+//            popping an empty vec is GENVEC_ERR_EMPTY and never prints)
+int genVec_push(genVec* vec, const u8* data);
 int genVec_pop(genVec* vec, u8* popped);
-void genVec_get(const genVec* vec, size_t i, u8* out);
-void genVec_replace(genVec* vec, size_t i, const u8* data);
-void genVec_insert(genVec* vec, size_t i, const u8* data);
-void genVec_insert_multi(genVec* vec, size_t i, const u8* data, size_t num_data);
-void genVec_remove(genVec* vec, size_t i);
-void genVec_front(const genVec* vec, u8* out);
-void genVec_back(const genVec* vec, u8* out);
+int genVec_get(const genVec* vec, size_t i, u8* out);
+int genVec_replace(genVec* vec, size_t i, const u8* data);
+int genVec_insert(genVec* vec, size_t i, const u8* data);
+int genVec_insert_multi(genVec* vec, size_t i, const u8* data, size_t num_data);
+int genVec_remove(genVec* vec, size_t i);
+int genVec_remove_range(genVec* vec, size_t i, size_t n);   // del_fn runs on each removed elm
+
+//bulk operations (amortized growth)
+int genVec_push_multi(genVec* vec, const u8* data, size_t num_data);
+int genVec_extend(genVec* dst, const genVec* src);
+int genVec_resize(genVec* vec, size_t n, const u8* fill);   // fill NULL zeroes new elms
+int genVec_front(const genVec* vec, u8* out);
+int genVec_back(const genVec* vec, u8* out);
+
+//stats (all zeros unless the library is built with GENVEC_STATS)
+void genVec_stats_get(const genVec* vec, genVec_stats* out);
+void genVec_stats_reset_vec(genVec* vec);
+#ifdef GENVEC_STATS
+void genVec_stats_move_(genVec* vec, size_t bytes);   // hook for the inline typed vecs
+#endif
+
+//copy on write - after genVec_share, genVec_copy/genVec_assign of vec are O(1) and share
+//its buffer. The first write through the API (push, insert, replace, remove, sort, ...)
+//gives that vec a private copy. Refcounts are atomic, so the copies can go to other
+//threads (each vec on its own is still single threaded). Elms can't own memory (no del_fn).
+int genVec_share(genVec* vec);      // moves the buffer into a refcounted block (one copy)
+int genVec_unshare(genVec* vec);    // private copy now, do this before writing through genVec_data/at
+// dst's elms are deleted and it becomes a copy of src, sharing src's buffer if it is
+// shared (and both use the same allocator). dst keeps its allocator and policy.
+int genVec_assign(genVec* dst, const genVec* src);
+
+static inline int genVec_is_shared(const genVec* vec) {
+    return vec ? (vec->flags & GENVEC_SHARED) != 0 : 0;
+}
+
+//growth/shrink hooks (also used by the typed vecs in gen_vector_typed.h)
+int genVec_ensure(genVec* vec, size_t needed);   // grow geometrically to fit needed elms, unshares
+void genVec_auto_shrink(genVec* vec);            // apply the shrink policy after removing
+
+//sorting and searching (cmp returns <0, 0, >0 like qsort)
+void genVec_sort(genVec* vec, genVec_compare_fn cmp);          // introsort, in place
+void genVec_stable_sort(genVec* vec, genVec_compare_fn cmp);   // merge sort, one size n temp buffer
+// splits the sort into n_threads slices on the default pool (0 = one per pool thread)
+// and merges them, cmp must be thread safe
+void genVec_sort_parallel(genVec* vec, genVec_compare_fn cmp, size_t n_threads);
+// vec must be sorted by cmp
+size_t genVec_lower_bound(const genVec* vec, const u8* key, genVec_compare_fn cmp);   // first elm >= key
+size_t genVec_upper_bound(const genVec* vec, const u8* key, genVec_compare_fn cmp);   // first elm > key
+u8* genVec_bsearch(const genVec* vec, const u8* key, genVec_compare_fn cmp);          // NULL if missing
+
+//iteration, in place on the buffer (no per elm copies)
+void genVec_for_each(genVec* vec, genVec_visit_fn fn, void* ctx);
+// dst's elms are deleted and replaced by fn(src elm), dst may have another data_size
+// (dst == src maps in place, in and out are then the same elm)
+int genVec_map_into(const genVec* src, genVec* dst, genVec_map_fn fn, void* ctx);
+size_t genVec_filter(genVec* vec, genVec_pred_fn keep, void* ctx);   // stable, del_fn runs on dropped elms, returns the new size
+void genVec_reduce(const genVec* vec, u8* acc, genVec_reduce_fn fn, void* ctx);
+
+// same, with data split into cache line aligned chunks over the built in thread pool
+// (n_threads caps the pieces, 0 = let every chunk be stolen). Callbacks run concurrently and must be thread safe.
+void genVec_for_each_parallel(genVec* vec, genVec_visit_fn fn, void* ctx, size_t n_threads);
+int genVec_map_into_parallel(const genVec* src, genVec* dst, genVec_map_fn fn, void* ctx, size_t n_threads);
+size_t genVec_filter_parallel(genVec* vec, genVec_pred_fn keep, void* ctx, size_t n_threads);
+// acc comes in holding an identity value (acc_size bytes), each chunk reduces into a copy
+// of it and the chunk results are combined into acc in order, same result for any n_threads
+int genVec_reduce_parallel(const genVec* vec, u8* acc, size_t acc_size, genVec_reduce_fn fn,
+                           genVec_combine_fn combine, void* ctx, size_t n_threads);
+
+//ownership transfer (no copying, both vecs must use the same allocator)
+void genVec_swap(genVec* a, genVec* b);
+int genVec_take(genVec* dst, genVec* src);      // dst's elms are deleted, src is left empty (same data_size/del_fn)
+// detach the buffer, the caller owns it (and its elms) and frees it with the vec's allocator
+// (an external buffer is just handed back)
+u8* genVec_release(genVec* vec, size_t* size, size_t* capacity);
+// new vec owning data, which must come from malloc
+genVec* genVec_adopt(u8* data, size_t size, size_t capacity, size_t data_size, genVec_delete_fn del_fn);
+
+//serialization - a 24 byte header (magic, version, flags, data_size, size) then the elms,
+//native byte order. Without a hook the elms go out as one raw block, which needs
+//elms that don't own memory (no del_fn); with one each elm goes through it.
+int genVec_write(const genVec* vec, FILE* f, genVec_write_fn write_fn);
+// data_size 0 accepts whatever the stream has, read_fn must match how it was written
+genVec* genVec_read(FILE* f, size_t data_size, genVec_delete_fn del_fn, genVec_read_fn read_fn);
 
 //utility
-genVec* genVec_copy(genVec* src);
+genVec* genVec_copy(genVec* src);   // O(1) when src is shared
 void genVec_print(const genVec* vec, genVec_print_fn fn);
 
 static inline size_t genVec_size(const genVec* vec) {
@@ -51,3 +192,39 @@ static inline int genVec_empty(const genVec* vec) {
     return vec ? vec->size == 0 : 0;
 }
 
+// zero copy access - pointers are invalidated by anything that can reallocate
+// (push, insert, reserve, shrinking pop/remove, ...). Writes through them need
+// genVec_unshare first on a shared vec.
+
+static inline u8* genVec_data(const genVec* vec) {
+    return vec ? vec->data : NULL;
+}
+
+static inline u8* genVec_begin(const genVec* vec) {
+    return vec ? vec->data : NULL;
+}
+
+// one past the last element
+static inline u8* genVec_end(const genVec* vec) {
+    return (vec && vec->data) ? vec->data + (vec->size * vec->data_size) : NULL;
+}
+
+// checked: NULL if vec is null or i is out of bounds
+static inline u8* genVec_at(const genVec* vec, size_t i) {
+    if (!vec || i >= vec->size) { return NULL; }
+    return vec->data + (i * vec->data_size);
+}
+
+// unchecked for hot loops, bounds are only asserted in debug builds
+static inline u8* genVec_at_unchecked(const genVec* vec, size_t i) {
+    assert(vec && i < vec->size);
+    return vec->data + (i * vec->data_size);
+}
+
+static inline u8* genVec_front_ptr(const genVec* vec) {
+    return genVec_at(vec, 0);
+}
+
+static inline u8* genVec_back_ptr(const genVec* vec) {
+    return (vec && vec->size > 0) ? genVec_at_unchecked(vec, vec->size - 1) : NULL;
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "gen_vector.h"
+#include <assert.h>
+#include <string.h>
+
+
+// Typed front end for genVec with sizeof(T) known at compile time, so element
+// access compiles to plain loads and stores instead of variable length memcpy.
+//
+//     GENVEC_DECLARE(int, IntVec)
+//
+//     genVec* v = IntVec_init(0);
+//     IntVec_push(v, 42);
+//     int x = IntVec_get(v, 0);
+//     genVec_destroy(v);
+//
+// The vec is still a plain genVec - growth, shrink policy, allocators and the
+// rest of the generic API all work on it. Bounds are only asserted (debug builds),
+// these are meant for hot paths. Mutators return 0 or -1 like the genVec calls
+// (a failed grow or unshare), an empty pop is GENVEC_ERR_EMPTY.
+
+// insert/remove shifts count in the stats of a GENVEC_STATS build
+#ifdef GENVEC_STATS
+    #define GENVEC_TYPED_MOVED(vec, bytes) genVec_stats_move_((vec), (bytes))
+#else
+    #define GENVEC_TYPED_MOVED(vec, bytes) ((void)0)
+#endif
+
+#define GENVEC_DECLARE(T, Name)                                                   \
+                                                                                  \
+static inline genVec* Name##_init(size_t n) {                                     \
+    return genVec_init(n, sizeof(T), NULL);                                       \
+}                                                                                 \
+                                                                                  \
+static inline T* Name##_data(const genVec* vec) {                                 \
+    assert(vec && vec->data_size == sizeof(T));                                   \
+    return (T*)vec->data;                                                         \
+}                                                                                 \
+                                                                                  \
+static inline T* Name##_at(const genVec* vec, size_t i) {                         \
+    assert(i < vec->size);                                                        \
+    return Name##_data(vec) + i;                                                  \
+}                                                                                 \
+                                                                                  \
+static inline T Name##_get(const genVec* vec, size_t i) {                         \
+    return *Name##_at(vec, i);                                                    \
+}                                                                                 \
+                                                                                  \
+static inline int Name##_set(genVec* vec, size_t i, T val) {                      \
+    if ((vec->flags & GENVEC_SHARED) && genVec_unshare(vec) != 0) { return -1; }  \
+    T* elm = Name##_at(vec, i);                                                   \
+    if (vec->del_fn) { vec->del_fn((u8*)elm); }                                   \
+    *elm = val;                                                                   \
+    return 0;                                                                     \
+}                                                                                 \
+                                                                                  \
+static inline int Name##_push(genVec* vec, T val) {                               \
+    if ((vec->size >= vec->capacity || (vec->flags & GENVEC_SHARED)) &&           \
+        genVec_ensure(vec, vec->size + 1) != 0) { return -1; }                    \
+    Name##_data(vec)[vec->size++] = val;                                          \
+    return 0;                                                                     \
+}                                                                                 \
+                                                                                  \
+static inline int Name##_pop(genVec* vec, T* popped) {                            \
+    if (vec->size == 0) {                                                         \
+        genVec_fail_quiet_(GENVEC_ERR_EMPTY);                                     \
+        return -1;                                                                \
+    }                                                                             \
+    T* last = Name##_data(vec) + --vec->size;                                     \
+    if (popped) { *popped = *last; }                                              \
+    else if (vec->del_fn) { vec->del_fn((u8*)last); }                             \
+    genVec_auto_shrink(vec);                                                      \
+    return 0;                                                                     \
+}                                                                                 \
+                                                                                  \
+static inline int Name##_insert(genVec* vec, size_t i, T val) {                   \
+    assert(i <= vec->size);                                                       \
+    if ((vec->size >= vec->capacity || (vec->flags & GENVEC_SHARED)) &&           \
+        genVec_ensure(vec, vec->size + 1) != 0) { return -1; }                    \
+    T* data = Name##_data(vec);                                                   \
+    memmove(data + i + 1, data + i, (vec->size - i) * sizeof(T));                 \
+    GENVEC_TYPED_MOVED(vec, (vec->size - i) * sizeof(T));                         \
+    data[i] = val;                                                                \
+    vec->size++;                                                                  \
+    return 0;                                                                     \
+}                                                                                 \
+                                                                                  \
+static inline int Name##_remove(genVec* vec, size_t i) {                          \
+    if ((vec->flags & GENVEC_SHARED) && genVec_unshare(vec) != 0) { return -1; }  \
+    T* data = Name##_data(vec);                                                   \
+    assert(i < vec->size);                                                        \
+    if (vec->del_fn) { vec->del_fn((u8*)(data + i)); }                            \
+    memmove(data + i, data + i + 1, (vec->size - i - 1) * sizeof(T));             \
+    GENVEC_TYPED_MOVED(vec, (vec->size - i - 1) * sizeof(T));                     \
+    vec->size--;                                                                  \
+    genVec_auto_shrink(vec);                                                      \
+    return 0;                                                                     \
+}
+
+
+// Inlined sort for a typed vec. less(a, b) takes two const T* and is called
+// directly instead of through a function pointer, so for small records the
+// whole comparison usually compiles down to a couple of instructions.
+//
+//     static inline int rec_less(const Rec* a, const Rec* b) { return a->key < b->key; }
+//     GENVEC_DECLARE_SORT(Rec, RecVec, rec_less)
+//
+//     RecVec_sort(vec);
+
+#define GENVEC_DECLARE_SORT(T, Name, less)                                        \
+                                                                                  \
+static inline void Name##_sort_insertion_(T* a, size_t n) {                       \
+    for (size_t i = 1; i < n; i++) {                                              \
+        T x = a[i];                                                               \
+        size_t j = i;                                                             \
+        while (j > 0 && less(&x, &a[j - 1])) { a[j] = a[j - 1]; j--; }            \
+        a[j] = x;                                                                 \
+    }                                                                             \
+}                                                                                 \
+                                                                                  \
+static inline void Name##_sort_sift_(T* a, size_t root, size_t n) {               \
+    for (;;) {                                                                    \
+        size_t child = 2 * root + 1;                                              \
+        if (child >= n) { return; }                                               \
+        if (child + 1 < n && less(&a[child], &a[child + 1])) { child++; }         \
+        if (!less(&a[root], &a[child])) { return; }                               \
+        T t = a[root]; a[root] = a[child]; a[child] = t;                          \
+        root = child;                                                             \
+    }                                                                             \
+}                                                                                 \
+                                                                                  \
+static inline void Name##_sort_intro_(T* a, size_t n, int depth) {                \
+    while (n > 16) {                                                              \
+        if (depth-- == 0) {                                                       \
+            for (size_t i = n / 2; i-- > 0;) { Name##_sort_sift_(a, i, n); }      \
+            for (size_t e = n - 1; e > 0; e--) {                                  \
+                T t = a[0]; a[0] = a[e]; a[e] = t;                                \
+                Name##_sort_sift_(a, 0, e);                                       \
+            }                                                                     \
+            return;                                                               \
+        }                                                                         \
+        /* median of three to a[0], a[n - 1] >= it bounds the left scan */       \
+        T* m = a + n / 2;                                                         \
+        T t;                                                                      \
+        if (less(m, a)) { t = *a; *a = *m; *m = t; }                              \
+        if (less(&a[n - 1], m)) {                                                 \
+            t = *m; *m = a[n - 1]; a[n - 1] = t;                                  \
+            if (less(m, a)) { t = *a; *a = *m; *m = t; }                          \
+        }                                                                         \
+        t = *a; *a = *m; *m = t;                                                  \
+        size_t i = 0, j = n;                                                      \
+        for (;;) {                                                                \
+            do { i++; } while (less(&a[i], &a[0]));                               \
+            do { j--; } while (less(&a[0], &a[j]));                               \
+            if (i >= j) { break; }                                                \
+            t = a[i]; a[i] = a[j]; a[j] = t;                                      \
+        }                                                                         \
+        t = a[0]; a[0] = a[j]; a[j] = t;                                          \
+        if (j < n - j - 1) {                                                      \
+            Name##_sort_intro_(a, j, depth);                                      \
+            a += j + 1;                                                           \
+            n -= j + 1;                                                           \
+        } else {                                                                  \
+            Name##_sort_intro_(a + j + 1, n - j - 1, depth);                      \
+            n = j;                                                                \
+        }                                                                         \
+    }                                                                             \
+    Name##_sort_insertion_(a, n);                                                 \
+}                                                                                 \
+                                                                                  \
+static inline void Name##_sort(genVec* vec) {                                     \
+    assert(vec && vec->data_size == sizeof(T));                                   \
+    if ((vec->flags & GENVEC_SHARED) && genVec_unshare(vec) != 0) { return; }     \
+    int depth = 0;                                                                \
+    for (size_t n = vec->size; n > 1; n >>= 1) { depth += 2; }                    \
+    Name##_sort_intro_((T*)vec->data, vec->size, depth);                          \
+}
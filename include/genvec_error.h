@@ -0,0 +1,37 @@
+#pragma once
+
+
+// Error reporting for every container in the library.
+//
+// A failing call records a code (and a short static message) in a thread local
+// slot instead of only printing, errno style: nothing resets it on success, so
+// clear it before the calls you want to check.
+//
+//     genVec_clear_error();
+//     genVec_push(vec, (u8*)&x);
+//     if (genVec_last_error() != GENVEC_OK) { ... }
+//
+// The messages are also printed to stdout, like they always were, unless the
+// library is built with GENVEC_NO_DIAGNOSTICS (cmake -DGENVEC_DIAGNOSTICS=OFF),
+// which strips the strings and the printing altogether. Expected outcomes such
+// as popping an empty vec only set the code and never print.
+
+typedef enum {
+    GENVEC_OK = 0,
+    GENVEC_ERR_NULL,        // a required pointer was NULL
+    GENVEC_ERR_BOUNDS,      // index or range out of bounds
+    GENVEC_ERR_EMPTY,       // pop/front/back on an empty container
+    GENVEC_ERR_ALLOC,       // an allocation failed
+    GENVEC_ERR_INVALID,     // any other bad argument (zero sizes, mismatched allocators, ...)
+    GENVEC_ERR_IO,          // a file or mapping operation failed
+} genVec_error;
+
+genVec_error genVec_last_error(void);
+const char* genVec_last_error_msg(void);   // the failing call's message (genVec_error_str when stripped)
+void genVec_clear_error(void);
+
+const char* genVec_error_str(genVec_error err);
+
+// records err without printing, for the library's inline functions (gen_vector_typed.h)
+void genVec_fail_quiet_(genVec_error err);
+
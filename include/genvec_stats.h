@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+
+// Opt in allocation statistics for genVec and String.
+//
+// Built with GENVEC_STATS (cmake -DGENVEC_STATS=ON) every genVec carries its own
+// counters and the library keeps global totals next to them. Without it the hooks
+// compile to nothing, genVec has no stats field and the snapshots read all zeros,
+// so code calling this API builds either way.
+//
+//     genVec_stats s;
+//     genVec_stats_global(&s);
+//     genVec_stats_dump(stderr, "after load", &s);
+//
+// A String counts on its genVec buffer: string_append and string_insert calls
+// land in str_appends/str_inserts, the reallocs and shifts they cause in the
+// other fields. The global totals are relaxed atomics, the per vec ones are plain
+// counters (a vec isn't synchronized anyway).
+
+typedef struct {
+    uint64_t grows;             // capacity increases (moving off an external buffer counts)
+    uint64_t shrinks;           // capacity decreases
+    uint64_t realloc_bytes;     // sizes of the blocks asked for by those
+    uint64_t moved_bytes;       // shifted by insert/remove
+    uint64_t peak_capacity;     // highest capacity: in elms for a vec, in bytes (of one vec) globally
+    uint64_t str_appends;
+    uint64_t str_inserts;
+} genVec_stats;
+
+typedef enum {
+    GENVEC_EV_GROW,             // a, b = old and new capacity in elms
+    GENVEC_EV_SHRINK,           // a, b = old and new capacity in elms
+    GENVEC_EV_MOVE,             // a = bytes shifted
+    GENVEC_EV_STR_APPEND,       // a = bytes appended
+    GENVEC_EV_STR_INSERT,       // a = bytes inserted
+} genVec_event;
+
+// vec is the genVec* the event happened on (a String's buffer for string events).
+// Runs on the thread doing the operation, inline in it - keep it short.
+typedef void (*genVec_trace_fn)(genVec_event ev, const void* vec, size_t a, size_t b, void* ctx);
+
+int genVec_stats_enabled(void);                 // 1 when the library was built with GENVEC_STATS
+
+void genVec_stats_global(genVec_stats* out);    // snapshot of the totals
+void genVec_stats_reset(void);                  // totals back to 0
+void genVec_stats_dump(FILE* f, const char* label, const genVec_stats* s);   // one key=value line
+
+// fn NULL turns tracing off. Set it before other threads start using the library.
+void genVec_stats_set_trace(genVec_trace_fn fn, void* ctx);
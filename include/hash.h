@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Fast seedable 64 bit hashing (wyhash style: two 64x64->128 multiplies per
+// 16 bytes, 48 byte stripes for long inputs). Not cryptographic, seed it if
+// keys can come from an attacker.
+
+#define HASH_DEFAULT_SEED 0
+
+uint64_t hash_bytes(const void* data, size_t len, uint64_t seed);
+uint64_t hash_cstr(const char* cstr, uint64_t seed);
+
+// cheap mixer for integer keys (and for combining hashes)
+static inline uint64_t hash_u64(uint64_t x) {
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+    return x;
+}
+
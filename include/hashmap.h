@@ -0,0 +1,69 @@
+#pragma once
+
+#include "gen_vector.h"
+#include "hash.h"
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Open addressing hash map (Swiss table style). One control byte per slot
+// holds 7 bits of the hash, so a probe checks 8 slots at a time with a few
+// word ops and only compares keys whose control byte already matched.
+//
+// Keys and values are stored inline as key_size/val_size bytes, like a genVec.
+// The map owns what is inserted: key_del/val_del run on removal, replacement
+// and destroy (NULL for plain data).
+
+typedef uint64_t (*hashmap_hash_fn)(const u8* key, size_t key_size);
+typedef int (*hashmap_eq_fn)(const u8* a, const u8* b, size_t key_size);   // nonzero if equal
+
+typedef struct {
+    genVec ctrl;            // capacity control bytes + a mirror of the first group
+    genVec keys;            // capacity slots of key_size
+    genVec vals;            // capacity slots of val_size (unused for val_size 0)
+    size_t size;
+    size_t capacity;        // power of 2, 0 before the first insert
+    size_t growth_left;     // inserts into empty slots before the next rehash
+    size_t key_size;
+    size_t val_size;
+    hashmap_hash_fn hash_fn;    // NULL hashes the key bytes
+    hashmap_eq_fn eq_fn;        // NULL memcmp's the key bytes
+    genVec_delete_fn key_del;
+    genVec_delete_fn val_del;
+} HashMap;
+
+
+// Construction/Destruction (val_size 0 makes a set)
+HashMap* hashmap_create(size_t key_size, size_t val_size, hashmap_hash_fn hash_fn, hashmap_eq_fn eq_fn,
+                        genVec_delete_fn key_del, genVec_delete_fn val_del);
+void hashmap_destroy(HashMap* map);
+void hashmap_clear(HashMap* map);       // keeps the capacity
+int hashmap_reserve(HashMap* map, size_t n);
+
+static inline size_t hashmap_size(const HashMap* map) {
+    return map ? map->size : 0;
+}
+
+// Insert a copy of key/val, 1 if new, 0 if an equal key was replaced
+// (the old key and value are deleted), -1 on error. val may be NULL for sets.
+int hashmap_insert(HashMap* map, const u8* key, const u8* val);
+
+// zero copy lookup, NULL if missing. Invalidated by the next insert.
+u8* hashmap_get(const HashMap* map, const u8* key);
+int hashmap_contains(const HashMap* map, const u8* key);
+
+// 1 if the key was there and got removed
+int hashmap_remove(HashMap* map, const u8* key);
+
+// Iteration in slot order, no inserts/removes while iterating.
+//
+//     size_t it = 0;
+//     u8 *key, *val;
+//     while (hashmap_next(map, &it, &key, &val)) { ... }
+int hashmap_next(const HashMap* map, size_t* it, u8** key, u8** val);
+
+// ready made hash/eq for String* keys (key_size = sizeof(String*)),
+// they use the cached string hash so a lookup key is hashed once
+uint64_t hashmap_string_hash(const u8* key, size_t key_size);
+int hashmap_string_eq(const u8* a, const u8* b, size_t key_size);
+
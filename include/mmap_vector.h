@@ -0,0 +1,67 @@
+#pragma once
+
+#include "gen_vector.h"
+#include <stddef.h>
+
+
+// genVec stored in a memory mapped file, so a big table is built once and
+// later processes just map it back in (no parsing, no load time realloc).
+//
+//     mmapVec* mv = mmapVec_open("table.bin", sizeof(Rec), MMAPVEC_RDWR);
+//     genVec* vec = mmapVec_vec(mv);
+//     genVec_push(vec, (u8*)&rec);       // the genVec API works on it (but see copies below)
+//     mmapVec_close(mv);
+//
+//     mmapVec* ro = mmapVec_open("table.bin", sizeof(Rec), MMAPVEC_RDONLY);
+//     genVec_get(mmapVec_vec(ro), i, (u8*)&rec);
+//
+// The file starts with a small header (magic, version, data_size, size,
+// capacity), followed by capacity elms. Growing the vec grows the file with
+// ftruncate and remaps it, so element pointers are invalidated like a realloc.
+// The elm count in the header is written by sync and close - a vec that was
+// never synced reopens at its last synced size.
+//
+// Elements are raw bytes on disk: no del_fn, and pointers inside elms are
+// meaningless once the process is gone. Close with mmapVec_close, never
+// genVec_destroy/deinit on the embedded vec. A read only vec can't grow (push and
+// friends fail with GENVEC_ERR_INVALID). It is mapped copy on write, so in place
+// edits (replace, remove, sort, writes through genVec_at) work but stay in this
+// process and never reach the file.
+//
+// The vec's allocator only ever resizes the file, it can't hand out other blocks, so
+// genVec_copy and genVec_share fail with GENVEC_ERR_INVALID. Copy into a heap vec:
+//
+//     genVec* heap = genVec_init(0, sizeof(Rec), NULL);
+//     genVec_assign(heap, mmapVec_vec(mv));     // or genVec_push_multi
+
+#define MMAPVEC_VERSION 1
+#define MMAPVEC_HEADER  64      // elms start this far into the file
+
+//flags
+#define MMAPVEC_RDONLY 0x0      // map an existing file read only
+#define MMAPVEC_RDWR   0x1      // read write, created if missing
+#define MMAPVEC_TRUNC  0x2      // with RDWR: start from an empty vec
+
+
+typedef struct {
+    genVec vec;                     // data points into the mapping, past the header
+    genVec_allocator allocator;     // grows/shrinks the file and remaps it
+    u8* map;                        // header + elms
+    size_t map_size;
+    int map_prot;                   // mmap protection and flags, reused on every remap
+    int map_flags;
+    int fd;
+    int flags;
+} mmapVec;
+
+
+// data_size 0 only for opening an existing file, it is then read from the header
+mmapVec* mmapVec_open(const char* path, size_t data_size, int flags);
+void mmapVec_close(mmapVec* mv);    // writes the header, unmaps (no forced flush)
+
+// header to the file and msync everything, 0 on success
+int mmapVec_sync(mmapVec* mv);
+
+static inline genVec* mmapVec_vec(mmapVec* mv) {
+    return mv ? &mv->vec : NULL;
+}
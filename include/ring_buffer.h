@@ -0,0 +1,70 @@
+#pragma once
+
+#include "gen_vector.h"
+#include <stddef.h>
+
+
+// Fixed capacity lock-free FIFO queues on genVec storage. Same element
+// conventions as genVec (data_size bytes copied in and out, del_fn runs on
+// whatever is still queued at destroy). Capacity is rounded up to a power of 2.
+//
+//   spscRing - exactly one producer thread and one consumer thread
+//   mpmcRing - any number of both (bounded queue with a sequence number per slot)
+//
+// push/pop are O(1) and never allocate. The _n versions move up to n elms
+// with one index update and return how many they moved.
+
+#define RING_CACHE_LINE 64
+
+
+typedef struct {
+    size_t head;            // next slot to read, written by the consumer
+    size_t tail_cache;      // consumer's last look at tail
+    char pad0[RING_CACHE_LINE - 2 * sizeof(size_t)];
+    size_t tail;            // next slot to write, written by the producer
+    size_t head_cache;      // producer's last look at head
+    char pad1[RING_CACHE_LINE - 2 * sizeof(size_t)];
+    genVec buffer;          // capacity slots, size == capacity
+    size_t mask;
+    genVec_delete_fn del_fn;
+} spscRing;
+
+spscRing* spscRing_create(size_t capacity, size_t data_size, genVec_delete_fn del_fn);
+void spscRing_destroy(spscRing* ring);
+
+// 0 on success, -1 if full / empty
+int spscRing_push(spscRing* ring, const u8* data);
+int spscRing_pop(spscRing* ring, u8* out);      // out NULL drops the elm (runs del_fn)
+size_t spscRing_push_n(spscRing* ring, const u8* data, size_t n);
+size_t spscRing_pop_n(spscRing* ring, u8* out, size_t n);
+
+size_t spscRing_size(const spscRing* ring);    // exact only when both sides are idle
+static inline size_t spscRing_capacity(const spscRing* ring) {
+    return ring ? ring->mask + 1 : 0;
+}
+
+
+typedef struct {
+    size_t head;            // next position to claim for reading
+    char pad0[RING_CACHE_LINE - sizeof(size_t)];
+    size_t tail;            // next position to claim for writing
+    char pad1[RING_CACHE_LINE - sizeof(size_t)];
+    genVec buffer;          // capacity slots, size == capacity
+    genVec seq;             // per slot sequence: pos when free for writing pos, pos + 1 once written
+    size_t mask;
+    genVec_delete_fn del_fn;
+} mpmcRing;
+
+mpmcRing* mpmcRing_create(size_t capacity, size_t data_size, genVec_delete_fn del_fn);
+void mpmcRing_destroy(mpmcRing* ring);
+
+int mpmcRing_push(mpmcRing* ring, const u8* data);
+int mpmcRing_pop(mpmcRing* ring, u8* out);
+size_t mpmcRing_push_n(mpmcRing* ring, const u8* data, size_t n);
+size_t mpmcRing_pop_n(mpmcRing* ring, u8* out, size_t n);
+
+size_t mpmcRing_size(const mpmcRing* ring);    // approximate while threads are active
+static inline size_t mpmcRing_capacity(const mpmcRing* ring) {
+    return ring ? ring->mask + 1 : 0;
+}
+
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "gen_vector.h"
+#include <stddef.h>
+
+
+// Segmented vector: elms live in fixed size blocks behind a directory, so
+// growing allocates one more block and never copies (or moves) an existing elm.
+// Pointers from segVec_at stay valid across push, pop (of other elms) and reserve.
+// segVec_remove(i) shifts the elms after i down, so pointers past i then point at
+// the next elm. segVec_clear frees every block.
+//
+//     segVec* sv = segVec_create(sizeof(Node), 0, NULL);
+//     segVec_push(sv, (u8*)&node);
+//     Node* n = (Node*)segVec_at(sv, i);      // i >> shift picks the block, i & mask the slot
+//
+// Blocks hold a power of 2 elms (block_elms is rounded up). Only the directory of
+// block pointers is a growing array; it is a genVec of u8*, so at 100M elms in
+// 4096 elm blocks it is ~200 KB of pointers. Popping past a block boundary frees
+// whole blocks, keeping one spare so a vec bouncing at a boundary doesn't thrash.
+// Not contiguous: no genVec_data style pointer, use at or copy out with to_genVec.
+
+#define SEGVEC_DEFAULT_BLOCK 4096   // elms per block when block_elms is 0
+
+
+typedef struct {
+    genVec blocks;              // u8* per allocated block
+    size_t size;
+    size_t data_size;
+    size_t shift;               // log2 of elms per block
+    size_t mask;                // elms per block - 1
+    genVec_delete_fn del_fn;
+} segVec;
+
+
+// Construction/Destruction
+segVec* segVec_create(size_t data_size, size_t block_elms, genVec_delete_fn del_fn);
+void segVec_destroy(segVec* sv);    // del_fn runs on every elm
+
+// Operations (int returns: 0 on success, -1 on failure with genVec_last_error() set)
+int segVec_push(segVec* sv, const u8* data);
+int segVec_pop(segVec* sv, u8* popped);     // popped NULL runs del_fn instead
+int segVec_get(const segVec* sv, size_t i, u8* out);
+int segVec_replace(segVec* sv, size_t i, const u8* data);   // del_fn runs on the old elm
+int segVec_remove(segVec* sv, size_t i);    // keeps order, shifts the elms after i (O(n))
+int segVec_reserve(segVec* sv, size_t n);   // allocates blocks up front
+void segVec_clear(segVec* sv);              // del_fn on every elm, frees every block
+void segVec_shrink_to_fit(segVec* sv);      // frees the spare blocks
+
+// contiguous copy, del_fn is not passed on (the elms are still owned by sv)
+genVec* segVec_to_genVec(const segVec* sv);
+
+static inline size_t segVec_size(const segVec* sv) {
+    return sv ? sv->size : 0;
+}
+
+static inline size_t segVec_capacity(const segVec* sv) {
+    return sv ? sv->blocks.size << sv->shift : 0;
+}
+
+// unchecked for hot loops, bounds are only asserted in debug builds
+static inline u8* segVec_at_unchecked(const segVec* sv, size_t i) {
+    assert(sv && i < sv->size);
+    return ((u8**)sv->blocks.data)[i >> sv->shift] + ((i & sv->mask) * sv->data_size);
+}
+
+// checked: NULL if sv is null or i is out of bounds
+static inline u8* segVec_at(const segVec* sv, size_t i) {
+    if (!sv || i >= sv->size) { return NULL; }
+    return ((u8**)sv->blocks.data)[i >> sv->shift] + ((i & sv->mask) * sv->data_size);
+}
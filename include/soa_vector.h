@@ -0,0 +1,78 @@
+#pragma once
+
+#include "gen_vector.h"
+#include <stddef.h>
+
+
+// Structure of arrays companion to genVec: every field of a row gets its own
+// contiguous column, so a scan over one field only pulls that field through cache.
+//
+//     typedef struct { uint64_t id; double price; uint32_t qty; char sym[8]; } Trade;
+//
+//     static const soaField trade_fields[] = {
+//         SOAVEC_FIELD(Trade, id), SOAVEC_FIELD(Trade, price),
+//         SOAVEC_FIELD(Trade, qty), SOAVEC_FIELD(Trade, sym),
+//     };
+//     soaVec* trades = soaVec_create(trade_fields, 4, sizeof(Trade));
+//
+//     soaVec_push(trades, (u8*)&t);                       // scattered into the columns
+//     const double* price = (const double*)soaVec_column(trades, 1);
+//     for (size_t i = 0; i < soaVec_size(trades); i++) { sum += price[i]; }
+//
+// Rows go in and out as row_size byte structs, fields are copied from and to
+// their offsets, so padding in the row type never reaches the columns. Each
+// column is a genVec and grows by its policy, and all of them always have the
+// same size. Fields are plain bytes (no del_fn).
+
+#define SOAVEC_MAX_FIELDS 64
+
+typedef struct {
+    size_t size;        // bytes of the field
+    size_t offset;      // where it sits in a row
+} soaField;
+
+#define SOAVEC_FIELD(T, member) { sizeof(((T*)0)->member), offsetof(T, member) }
+
+
+typedef struct {
+    genVec* cols;           // n_fields columns, cols[f].data_size == fields[f].size
+    soaField* fields;
+    size_t n_fields;
+    size_t row_size;
+} soaVec;
+
+
+// Construction/Destruction - fields are copied, each must fit inside row_size
+soaVec* soaVec_create(const soaField* fields, size_t n_fields, size_t row_size);
+void soaVec_destroy(soaVec* sv);
+
+// Rows (int returns: 0 on success, -1 on failure with genVec_last_error() set)
+int soaVec_push(soaVec* sv, const u8* row);
+int soaVec_pop(soaVec* sv, u8* row);                 // row NULL just drops it
+int soaVec_get(const soaVec* sv, size_t i, u8* row); // gathers the fields into row
+int soaVec_set(soaVec* sv, size_t i, const u8* row);
+int soaVec_remove(soaVec* sv, size_t i);             // keeps order, shifts every column
+int soaVec_swap_remove(soaVec* sv, size_t i);        // last row moves into i, O(1)
+int soaVec_reserve(soaVec* sv, size_t n);
+void soaVec_clear(soaVec* sv);                        // drops every row, frees the columns
+
+static inline size_t soaVec_size(const soaVec* sv) {
+    return sv ? sv->cols[0].size : 0;
+}
+
+// Columns - pointers are invalidated by anything that can reallocate (push,
+// reserve, shrinking pop/remove). soaVec_col hands out the column genVec for the
+// read only / in place genVec API (reduce, for_each, ...), never change its size.
+
+static inline u8* soaVec_column(const soaVec* sv, size_t field) {
+    return (sv && field < sv->n_fields) ? sv->cols[field].data : NULL;
+}
+
+static inline genVec* soaVec_col(const soaVec* sv, size_t field) {
+    return (sv && field < sv->n_fields) ? &sv->cols[field] : NULL;
+}
+
+// checked: NULL if field or i is out of bounds
+static inline u8* soaVec_field_at(const soaVec* sv, size_t field, size_t i) {
+    return (sv && field < sv->n_fields) ? genVec_at(&sv->cols[field], i) : NULL;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+
+
+// Work stealing thread pool, used by the _parallel genVec algorithms and open
+// for direct use.
+//
+// Every worker owns a Chase-Lev deque: tasks it spawns go on the bottom and it
+// pops them back LIFO (cache warm), idle workers steal from the top of someone
+// else's. Threads outside the pool spawn into a shared injection queue. A
+// thread waiting on a group runs other tasks meanwhile, so fork/join nests to
+// any depth without blocking a worker.
+//
+//     static void visit(void* arg) { ... }
+//
+//     taskGroup g;
+//     task t[2];
+//     task_group_init(&g);
+//     task_spawn(pool, &g, &t[0], visit, left);
+//     task_spawn(pool, &g, &t[1], visit, right);
+//     task_wait(pool, &g);
+//
+// Tasks are caller owned (usually on the spawner's stack), spawning never
+// allocates. A task and its group must stay alive until task_wait returns.
+
+typedef struct ThreadPool ThreadPool;
+
+typedef void (*task_fn)(void* arg);
+typedef void (*tpool_range_fn)(void* ctx, size_t i);
+
+typedef struct {
+    size_t pending;     // spawned tasks that haven't finished (atomic)
+} taskGroup;
+
+typedef struct {
+    task_fn fn;
+    void* arg;
+    taskGroup* group;
+} task;
+
+
+// n_threads counts the caller too (n_threads - 1 workers are started), 0 = one per cpu
+ThreadPool* tpool_create(size_t n_threads);
+ThreadPool* tpool_create_pinned(size_t n_threads);   // worker i stays on cpu i % ncpu (Linux)
+void tpool_destroy(ThreadPool* pool);                // no tasks may still be pending
+size_t tpool_size(const ThreadPool* pool);
+
+// shared pool, created on first use with one thread per cpu and never destroyed.
+// tpool_init_default configures it up front, -1 if it already exists.
+ThreadPool* tpool_default(void);
+int tpool_init_default(size_t n_threads, int pinned);
+
+// fork/join - a full local deque (or injection queue) just runs the task right away
+static inline void task_group_init(taskGroup* group) {
+    group->pending = 0;
+}
+void task_spawn(ThreadPool* pool, taskGroup* group, task* t, task_fn fn, void* arg);
+void task_wait(ThreadPool* pool, taskGroup* group);
+
+// fn(ctx, i) for every i in [0, n), on any thread in any order, returns once all
+// of them are done. The range is split in halves recursively, so idle threads
+// steal big pieces first. max_pieces caps the split (0 = down to single indices,
+// 1 = run it all on the calling thread).
+void tpool_parallel_for(ThreadPool* pool, size_t n, size_t max_pieces, tpool_range_fn fn, void* ctx);
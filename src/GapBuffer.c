@@ -0,0 +1,255 @@
+#include "GapBuffer.h"
+#include "genvec_diag.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// always leave at least this much gap after growing, so typing doesn't regrow
+#define GAPBUF_MIN_GAP 64
+
+
+// Private helpers
+
+static inline char* gb_data(const GapBuffer* gb) {
+    return (char*)gb->buffer.data;
+}
+
+static inline size_t gb_gap(const GapBuffer* gb) {
+    return gb->gap_end - gb->gap_start;
+}
+
+// move the gap so that it starts at text index i (i <= len)
+static void gapbuf_move_gap(GapBuffer* gb, size_t i)
+{
+    char* data = gb_data(gb);
+
+    if (i < gb->gap_start) {
+        // text in [i, gap_start) moves to just before gap_end
+        size_t n = gb->gap_start - i;
+        memmove(data + gb->gap_end - n, data + i, n);
+        gb->gap_start -= n;
+        gb->gap_end -= n;
+    } else if (i > gb->gap_start) {
+        // text right after the gap moves down to gap_start
+        size_t n = i - gb->gap_start;
+        memmove(data + gb->gap_start, data + gb->gap_end, n);
+        gb->gap_start += n;
+        gb->gap_end += n;
+    }
+}
+
+// make the gap at least n bytes, the text after it moves to the new end
+static int gapbuf_ensure_gap(GapBuffer* gb, size_t n)
+{
+    if (gb_gap(gb) >= n) { return 0; }
+
+    size_t old_size = gb->buffer.size;
+    size_t needed = old_size - gb_gap(gb) + n + GAPBUF_MIN_GAP;
+
+    if (GENVEC_UNLIKELY(genVec_ensure(&gb->buffer, needed) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "gapbuf: growing the gap failed");
+        return -1;
+    }
+
+    size_t new_size = gb->buffer.capacity;
+    size_t tail = old_size - gb->gap_end;
+    char* data = gb_data(gb);
+
+    memmove(data + new_size - tail, data + gb->gap_end, tail);
+    gb->gap_end = new_size - tail;
+    gb->buffer.size = new_size;
+
+    return 0;
+}
+
+
+GapBuffer* gapbuf_create(void)
+{
+    GapBuffer* gb = malloc(sizeof(GapBuffer));
+    if (GENVEC_UNLIKELY(!gb)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "gapbuf create: malloc failed");
+        return NULL;
+    }
+
+    if (genVec_init_inplace(&gb->buffer, 0, sizeof(char), NULL) != 0) {
+        free(gb);
+        return NULL;
+    }
+
+    gb->gap_start = 0;
+    gb->gap_end = 0;
+    return gb;
+}
+
+GapBuffer* gapbuf_from_cstr(const char* cstr)
+{
+    if (GENVEC_UNLIKELY(!cstr)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "gapbuf from cstr: cstr is null");
+        return NULL;
+    }
+
+    GapBuffer* gb = gapbuf_create();
+    if (!gb) { return NULL; }
+
+    gapbuf_append_cstr(gb, cstr);
+    return gb;
+}
+
+void gapbuf_destroy(GapBuffer* gb) {
+    if (gb) {
+        genVec_deinit(&gb->buffer);
+        free(gb);
+    }
+}
+
+void gapbuf_insert_n(GapBuffer* gb, size_t i, const char* data, size_t len)
+{
+    if (GENVEC_UNLIKELY(!gb || (!data && len > 0))) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "gapbuf insert: invalid parameters");
+        return;
+    }
+    if (len == 0) { return; }
+
+    size_t text_len = gapbuf_len(gb);
+    if (i > text_len) { i = text_len; } // past the end appends
+
+    // data could be our own text (a gapbuf_views view), which moving or growing
+    // the gap shifts. Keep its text index and find it again afterwards
+    const char* base = gb_data(gb);
+    int aliased = base && data >= base && data < base + gb->buffer.size;
+    size_t src = 0;
+    if (aliased) {
+        size_t p = (size_t)(data - base);
+        if (p + len <= gb->gap_start) {
+            src = p;
+        } else if (p >= gb->gap_end) {
+            src = p - gb_gap(gb);
+        } else {
+            GENVEC_FAIL(GENVEC_ERR_INVALID, "gapbuf insert: data spans the gap");
+            return;
+        }
+    }
+
+    gapbuf_move_gap(gb, i);
+    if (gapbuf_ensure_gap(gb, len) != 0) { return; }
+
+    char* buf = gb_data(gb);
+    char* dst = buf + gb->gap_start;
+    if (!aliased) {
+        memcpy(dst, data, len);
+    } else {
+        // the source text before i is still in front of the gap, the rest is after it
+        size_t head = src >= i ? 0 : (src + len <= i ? len : i - src);
+        memcpy(dst, buf + src, head);
+        if (len > head) { memcpy(dst + head, buf + gb->gap_end + (src + head - i), len - head); }
+    }
+    gb->gap_start += len;
+}
+
+void gapbuf_insert_char(GapBuffer* gb, size_t i, char c) {
+    gapbuf_insert_n(gb, i, &c, 1);
+}
+
+void gapbuf_insert_cstr(GapBuffer* gb, size_t i, const char* cstr) {
+    if (GENVEC_UNLIKELY(!cstr)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "gapbuf insert cstr: cstr is null");
+        return;
+    }
+    gapbuf_insert_n(gb, i, cstr, strlen(cstr));
+}
+
+void gapbuf_append_cstr(GapBuffer* gb, const char* cstr) {
+    gapbuf_insert_cstr(gb, gapbuf_len(gb), cstr);
+}
+
+void gapbuf_append_char(GapBuffer* gb, char c) {
+    gapbuf_insert_n(gb, gapbuf_len(gb), &c, 1);
+}
+
+void gapbuf_remove_range(GapBuffer* gb, size_t i, size_t n)
+{
+    if (GENVEC_UNLIKELY(!gb)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "gapbuf remove: gb is null");
+        return;
+    }
+
+    size_t len = gapbuf_len(gb);
+    if (GENVEC_UNLIKELY(i > len || n > len - i)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "gapbuf remove: range out of bounds");
+        return;
+    }
+
+    // put the gap right before the range, then just widen it over the range
+    gapbuf_move_gap(gb, i);
+    gb->gap_end += n;
+}
+
+void gapbuf_remove_char(GapBuffer* gb, size_t i) {
+    if (GENVEC_UNLIKELY(!gb || i >= gapbuf_len(gb))) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "gapbuf remove char: gb null or i out of bounds");
+        return;
+    }
+    gapbuf_remove_range(gb, i, 1);
+}
+
+void gapbuf_clear(GapBuffer* gb) {
+    if (GENVEC_UNLIKELY(!gb)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "gapbuf clear: gb is null");
+        return;
+    }
+
+    // the whole buffer becomes gap, capacity is kept
+    gb->gap_start = 0;
+    gb->gap_end = gb->buffer.size;
+}
+
+char gapbuf_at(const GapBuffer* gb, size_t i) {
+    if (GENVEC_UNLIKELY(!gb || i >= gapbuf_len(gb))) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "gapbuf at: gb null or i out of bounds");
+        return '\0';
+    }
+
+    return i < gb->gap_start ? gb_data(gb)[i] : gb_data(gb)[i + gb_gap(gb)];
+}
+
+void gapbuf_set_char(GapBuffer* gb, size_t i, char c) {
+    if (GENVEC_UNLIKELY(!gb || i >= gapbuf_len(gb))) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "gapbuf set char: gb null or i out of bounds");
+        return;
+    }
+
+    if (i < gb->gap_start) { gb_data(gb)[i] = c; }
+    else                   { gb_data(gb)[i + gb_gap(gb)] = c; }
+}
+
+void gapbuf_views(const GapBuffer* gb, StringView* before, StringView* after)
+{
+    if (GENVEC_UNLIKELY(!gb || !before || !after)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "gapbuf views: invalid parameters");
+        return;
+    }
+
+    *before = sv_make(gb_data(gb), gb->gap_start);
+    *after = sv_make(gb_data(gb) ? gb_data(gb) + gb->gap_end : NULL, gb->buffer.size - gb->gap_end);
+}
+
+String* gapbuf_to_string(const GapBuffer* gb)
+{
+    if (GENVEC_UNLIKELY(!gb)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "gapbuf to string: gb is null");
+        return NULL;
+    }
+
+    String* str = string_create();
+    if (!str) { return NULL; }
+
+    StringView before, after;
+    gapbuf_views(gb, &before, &after);
+
+    string_reserve(str, before.len + after.len);
+    string_append_view(str, before);
+    string_append_view(str, after);
+
+    return str;
+}
@@ -1,275 +1,722 @@
+#define _POSIX_C_SOURCE 200809L     // flockfile, getc_unlocked
+
 #include "String.h"
 #include "gen_vector.h"
+#include "string_simd.h"
+#include "hash.h"
+#include "genvec_diag.h"
+#include "genvec_stats_hooks.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 
 
-// Private helper to ensure null termination
-static inline void ensure_null_terminated(String* str) {
-    if (!str || !str->buffer) { return; }
-    
-    size_t size = str->buffer->size;
-    if (size == 0 || ((char*)str->buffer->data)[size - 1] != '\0') 
-    {
-        const char null_term = '\0';
-        genVec_push(str->buffer, (u8*)&null_term);
+// Private helpers - the buffer always holds the chars + null terminator,
+// on sso while it fits and on the heap after that
+
+static inline char* str_data(const String* str) {
+    return (char*)str->buffer.data;
+}
+
+// sets the length and writes the null terminator (capacity must already be there),
+// every mutation goes through here (or clears hash itself) so the cached hash goes stale
+static inline void str_set_len(String* str, size_t len) {
+    str->hash = 0;
+    str->buffer.size = len + 1;
+    str_data(str)[len] = '\0';
+}
+
+// cached encoding state (str->text). Appends keep it exact: a valid string ends on a
+// character boundary, so valid + new bytes is valid exactly when the new bytes are.
+// Edits that could go either way drop it to unknown, str_text works it out again.
+#define STR_TEXT_UNKNOWN 0
+#define STR_TEXT_ASCII   1
+#define STR_TEXT_UTF8    2      // valid, with at least one multibyte character
+#define STR_TEXT_INVALID 3
+
+static inline int str_text_valid(uint32_t text) {
+    return text == STR_TEXT_ASCII || text == STR_TEXT_UTF8;
+}
+
+static inline uint32_t str_text_check(const char* s, size_t n)
+{
+    // short pieces (single words, numbers) aren't worth the call, two overlapping
+    // words cover 8..15 bytes
+    if (n < 16) {
+        uint64_t high = 0;
+        if (n >= 8) {
+            uint64_t head, tail;
+            memcpy(&head, s, sizeof(head));
+            memcpy(&tail, s + n - 8, sizeof(tail));
+            high = head | tail;
+        } else {
+            for (size_t i = 0; i < n; i++) { high |= (unsigned char)s[i]; }
+        }
+        if (!(high & 0x8080808080808080ull)) { return STR_TEXT_ASCII; }
+    }
+
+    switch (str_simd_utf8_check(s, n)) {
+    case STR_UTF8_ASCII: return STR_TEXT_ASCII;
+    case STR_UTF8_VALID: return STR_TEXT_UTF8;
+    default:             return STR_TEXT_INVALID;
+    }
+}
+
+// n bytes just appended at s. Once invalid, more bytes could complete a cut off character
+static inline void str_text_append(String* str, const char* s, size_t n)
+{
+    if (!str_text_valid(str->text)) {
+        str->text = STR_TEXT_UNKNOWN;
+        return;
+    }
+
+    uint32_t added = str_text_check(s, n);
+    if (added != STR_TEXT_ASCII) { str->text = added; }
+}
+
+// the cache is not part of the value, so const callers can fill it (like the hash)
+static uint32_t str_text(const String* str)
+{
+    if (str->text == STR_TEXT_UNKNOWN) {
+        ((String*)str)->text = str_text_check(str_data(str), string_len(str));
+    }
+    return str->text;
+}
+
+static inline void* str_mem_alloc(const genVec_allocator* alloc, size_t size) {
+    return alloc ? alloc->alloc(alloc->ctx, size) : malloc(size);
+}
+
+static inline void str_mem_free(const genVec_allocator* alloc, void* ptr, size_t size) {
+    if (alloc) { alloc->free(alloc->ctx, ptr, size); }
+    else       { free(ptr); }
+}
+
+static inline void str_init_sso(String* str) {
+    genVec_init_buffer(&str->buffer, (u8*)str->sso, STRING_SSO_SIZE, sizeof(char), NULL);
+    str_set_len(str, 0);
+    str->text = STR_TEXT_ASCII;
+}
+
+// copy on write: a shared buffer gets a private copy before the first write
+static inline int str_own(String* str) {
+    return GENVEC_UNLIKELY(genVec_is_shared(&str->buffer)) ? genVec_unshare(&str->buffer) : 0;
+}
+
+// make room for len chars + null terminator, moving off sso if it is too small
+static int str_reserve(String* str, size_t len)
+{
+    if (len + 1 <= str->buffer.capacity) { return 0; }
+
+    // grow geometrically so repeated appends stay amortized O(1)
+    size_t new_cap = str->buffer.capacity + (str->buffer.capacity >> 1);
+    if (new_cap < len + 1) { new_cap = len + 1; }
+
+    genVec_reserve(&str->buffer, new_cap);
+    if (GENVEC_UNLIKELY(str->buffer.capacity < len + 1)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "str reserve: genVec_reserve failed");
+        return -1;
+    }
+    return 0;
+}
+
+// append n bytes at the end, src may point into str itself
+static void str_append_bytes(String* str, const char* src, size_t n)
+{
+    if (n == 0) { return; }
+    GENVEC_STAT_STRING(&str->buffer, GENVEC_EV_STR_APPEND, n);
+
+    size_t len = string_len(str);
+
+    if (len + n + 1 > str->buffer.capacity || genVec_is_shared(&str->buffer)) {
+        // src could be str's own data, which str_reserve (or unsharing) may move
+        const char* old_data = str_data(str);
+        int aliased = (src >= old_data && src <= old_data + len);
+        size_t src_off = (size_t)(src - old_data);
+
+        if (str_own(str) != 0 || str_reserve(str, len + n) != 0) { return; }
+        if (aliased) { src = str_data(str) + src_off; }
+    }
+
+    // appended region never overlaps src, even when src is inside str
+    char* data = str_data(str);
+    memcpy(data + len, src, n);
+    str_set_len(str, len + n);
+    str_text_append(str, data + len, n);
+}
+
+// insert n bytes at i (i <= len), src may point into str itself
+static void str_insert_bytes(String* str, size_t i, const char* src, size_t n)
+{
+    if (n == 0) { return; }
+    GENVEC_STAT_STRING(&str->buffer, GENVEC_EV_STR_INSERT, n);
+
+    size_t len = string_len(str);
+
+    // src could be str's own data, which str_reserve (or unsharing) may move
+    const char* old_data = str_data(str);
+    int aliased = (src >= old_data && src <= old_data + len);
+    size_t src_off = aliased ? (size_t)(src - old_data) : 0;
+
+    if (str_own(str) != 0 || str_reserve(str, len + n) != 0) { return; }
+
+    char* data = str_data(str);
+    if (aliased) { src = data + src_off; }
+
+    // shift the tail (including null terminator) right by n
+    memmove(data + i + n, data + i, len - i + 1);
+    GENVEC_STAT_MOVE(&str->buffer, len - i + 1);
+
+    // the tail shift moves any part of src that was past i
+    if (aliased) {
+        if (src_off >= i) {
+            memcpy(data + i, src + n, n);
+        } else if (src_off + n > i) {
+            size_t head = i - src_off;
+            memcpy(data + i, src, head);
+            memcpy(data + i + head, data + i + n, n - head);
+        } else {
+            memcpy(data + i, src, n);
+        }
+    } else {
+        memcpy(data + i, src, n);
+    }
+
+    str_set_len(str, len + n);
+
+    // between two characters of valid text, the result is as valid as the insert.
+    // The old byte at i (now at i + n) tells, in valid text every other byte starts one
+    if (!str_text_valid(str->text) || ((unsigned char)data[i + n] & 0xC0) == 0x80) {
+        str->text = STR_TEXT_UNKNOWN;
+    } else {
+        uint32_t added = str_text_check(data + i, n);
+        if (added != STR_TEXT_ASCII) { str->text = added; }
     }
 }
 
+
 String* string_create(void) {
-    String* str = malloc(sizeof(String));
-    if (!str) { 
-        printf("str create: malloc failed\n");
-        return NULL; 
-    }
-    
-    // we get a pointer to buffer
-    str->buffer = genVec_init(0, sizeof(char), NULL);
-    if (!str->buffer) {
-        printf("str create: genVec_init failed\n");
-        free(str);
+    return string_create_alloc(NULL);
+}
+
+String* string_create_alloc(const genVec_allocator* alloc) {
+    String* str = str_mem_alloc(alloc, sizeof(String));
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "str create: malloc failed");
         return NULL;
     }
-    
-    ensure_null_terminated(str);
+
+    // buffer starts on the inline storage, no data allocation yet
+    str_init_sso(str);
+    genVec_set_allocator(&str->buffer, alloc);
     return str;
 }
 
 
-void string_create_onstack(String* str, const char* cstr) 
+void string_create_onstack(String* str, const char* cstr)
 {
     // the difference is that we dont use string_create(), so str is not heap initilised
-    if (!str) {
-        printf("str create stk: str is null\n");
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str create stk: str is null");
         return;
     }
 
-    str->buffer = genVec_init(0, sizeof(char), NULL);
-    if (!str->buffer) {
-        printf("str create stk: buffer genvec failed\n");
-        return;
-    }
-    
-    string_append_cstr(str, cstr); 
+    str_init_sso(str);
+
+    string_append_cstr(str, cstr);
 }
 
 String* string_from_cstr(const char* cstr) {
-    if (!cstr) { 
-        printf("str from cstr: cstr is null\n");
-        return NULL; 
+    if (GENVEC_UNLIKELY(!cstr)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str from cstr: cstr is null");
+        return NULL;
     }
-    
+
     String* str = string_create();
-    if (!str) { 
-        printf("str from cstr: string_create failed\n");
-        return NULL; 
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "str from cstr: string_create failed");
+        return NULL;
     }
-    
+
     string_append_cstr(str, cstr);
     return str;
 }
 
 String* string_from_string(const String* other) {
-    if (!other) { 
-        printf("string from string: other is null\n");
-        return NULL; 
+    if (GENVEC_UNLIKELY(!other)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "string from string: other is null");
+        return NULL;
+    }
+
+    String* str = string_create_alloc(other->buffer.alloc);
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "str from str: string_create failed");
+        return NULL;
     }
-    return string_from_cstr(string_to_cstr(other));
+
+    // a shared buffer is just referenced, O(1) whatever the length
+    if (genVec_is_shared(&other->buffer)) {
+        genVec_assign(&str->buffer, &other->buffer);
+        str->hash = other->hash;
+        str->text = other->text;
+        return str;
+    }
+
+    // we already know the length, no need to strlen again
+    str_append_bytes(str, str_data(other), string_len(other));
+    return str;
+}
+
+String* string_from_view(StringView sv) {
+    if (GENVEC_UNLIKELY(!sv.ptr && sv.len > 0)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str from view: view is null");
+        return NULL;
+    }
+
+    String* str = string_create();
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "str from view: string_create failed");
+        return NULL;
+    }
+
+    str_append_bytes(str, sv.ptr, sv.len);
+    return str;
 }
 
-void string_reserve(String* str, size_t capacity) 
+void string_reserve(String* str, size_t capacity)
 {
-    if (!str || !str->buffer) { return; }
-    
-    // Add 1 for null terminator
-    capacity++;
-    
-    // Use genVec_reserve to pre-allocate
-    genVec_reserve(str->buffer, capacity);
-    
-    // Ensure null termination is preserved
-    ensure_null_terminated(str);
+    if (!str) { return; }
+
+    // str_reserve adds 1 for the null terminator
+    str_reserve(str, capacity);
+}
+
+int string_share(String* str)
+{
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str share: str is null");
+        return -1;
+    }
+
+    // inline strings stay inline, copying those is already cheap
+    if (str->buffer.flags & GENVEC_EXTERNAL) { return 0; }
+    return genVec_share(&str->buffer);
 }
 
 void string_destroy(String* str) {
     if (str) {
-        genVec_destroy(str->buffer);
-        free(str);
+        const genVec_allocator* alloc = str->buffer.alloc;
+
+        genVec_deinit(&str->buffer);
+        str_mem_free(alloc, str, sizeof(String));
     }
 }
 
-// cant free the stack allocated string, but buffer is heap. So seperate delete 
+// cant free the stack allocated string, but buffer is heap. So seperate delete
 void string_destroy_fromstk(String* str) {
-    if (str->buffer) {
-        genVec_destroy(str->buffer);
+    if (!str) { return; }
+
+    const genVec_allocator* alloc = str->buffer.alloc;
+
+    genVec_deinit(&str->buffer);
+    str_init_sso(str);
+    genVec_set_allocator(&str->buffer, alloc);
+}
+
+void string_move(String* dst, String* src)
+{
+    if (GENVEC_UNLIKELY(!dst || !src)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str move: parameters null");
+        return;
     }
+    if (dst == src) { return; }
+
+    // inline contents (or a different allocator) can't be stolen, copy those
+    if ((src->buffer.flags & GENVEC_EXTERNAL) || src->buffer.alloc != dst->buffer.alloc) {
+        string_clear(dst);
+        str_append_bytes(dst, str_data(src), string_len(src));
+        string_clear(src);
+        return;
+    }
+
+    // heap buffer changes hands, src goes back to empty inline storage
+    const genVec_allocator* alloc = src->buffer.alloc;
+    uint64_t hash = src->hash;
+    uint32_t text = src->text;
+
+    genVec_take(&dst->buffer, &src->buffer);
+    dst->hash = hash;
+    dst->text = text;
+
+    str_init_sso(src);
+    genVec_set_allocator(&src->buffer, alloc);
+}
+
+char* string_release_cstr(String* str, size_t* len)
+{
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str release cstr: str is null");
+        return NULL;
+    }
+
+    size_t n = string_len(str);
+    if (len) { *len = n; }
+
+    char* cstr;
+    if (!(str->buffer.flags & (GENVEC_EXTERNAL | GENVEC_SHARED)) && !str->buffer.alloc) {
+        // a malloc'd heap buffer is handed over as is
+        cstr = (char*)genVec_release(&str->buffer, NULL, NULL);
+    } else {
+        // inline, shared or custom allocator memory: copy so the caller can always free()
+        cstr = malloc(n + 1);
+        if (GENVEC_UNLIKELY(!cstr)) {
+            GENVEC_FAIL(GENVEC_ERR_ALLOC, "str release cstr: malloc failed");
+            return NULL;
+        }
+        memcpy(cstr, str_data(str), n + 1);
+        genVec_deinit(&str->buffer);
+    }
+
+    const genVec_allocator* alloc = str->buffer.alloc;
+    str_init_sso(str);
+    genVec_set_allocator(&str->buffer, alloc);
+    return cstr;
 }
 
 const char* string_to_cstr(const String* str) {
-    if (!str || !str->buffer || str->buffer->size == 0) { 
-        return ""; 
+    if (!str) {
+        return "";
     }
-    
-    return (const char*)str->buffer->data;
+
+    return str_data(str);
 }
 
-void string_append_cstr(String* str, const char* cstr) 
+void string_append_cstr(String* str, const char* cstr)
 {
-    if (!str || !cstr || !str->buffer) { 
-        printf("str append cstr: invalid parameters\n");
-        return; 
-    }
-    
-    size_t cstr_len = strlen(cstr);
-    if (cstr_len == 0) { return; }// Nothing to append
-
-    // Calculate where to start writing (before null terminator (if it exists))
-    size_t write_pos = str->buffer->size;
-    if (write_pos > 0) {
-        char last_char;
-        genVec_get(str->buffer, write_pos - 1, (u8*)&last_char);
-        if (last_char == '\0') {
-            write_pos--; // Overwrite the null terminator
-            str->buffer->size--; // Temporarily reduce size
-        }
+    if (GENVEC_UNLIKELY(!str || !cstr)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str append cstr: invalid parameters");
+        return;
+    }
+
+    str_append_bytes(str, cstr, strlen(cstr));
+}
+
+void string_append_n(String* str, const char* data, size_t len)
+{
+    if (GENVEC_UNLIKELY(!str || (!data && len > 0))) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str append n: invalid parameters");
+        return;
     }
-    
-    genVec_insert_multi(str->buffer, write_pos, (const u8*)cstr, cstr_len);
-    
-    // Ensure null termination
-   ensure_null_terminated(str); 
+
+    str_append_bytes(str, data, len);
 }
 
 void string_append_string(String* str, const String* other) {
-    if (!str || !other) { 
-        printf("str append str: parameters null\n");
-        return; 
+    if (GENVEC_UNLIKELY(!str || !other)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str append str: parameters null");
+        return;
     }
-    string_append_cstr(str, string_to_cstr(other));
+    str_append_bytes(str, str_data(other), string_len(other));
+}
+
+void string_append_view(String* str, StringView sv) {
+    if (GENVEC_UNLIKELY(!str || (!sv.ptr && sv.len > 0))) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str append view: invalid parameters");
+        return;
+    }
+    str_append_bytes(str, sv.ptr, sv.len);
 }
 
 void string_append_char(String* str, char c) {
-    if (!str) { 
-        printf("str append char: str null\n");
-        return; 
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str append char: str null");
+        return;
     }
-    
-    // Remove null terminator temporarily
-    if (str->buffer->size > 0) {
-        genVec_pop(str->buffer, NULL);
+
+    GENVEC_STAT_STRING(&str->buffer, GENVEC_EV_STR_APPEND, 1);
+    if (str_own(str) != 0) { return; }
+
+    // single capacity check, then write c and the terminator in place
+    size_t size = str->buffer.size;
+    if (size + 1 > str->buffer.capacity) {
+        if (str_reserve(str, size) != 0) { return; }
     }
-    
-    genVec_push(str->buffer, (u8*)&c);
-    ensure_null_terminated(str);
+
+    char* data = str_data(str);
+    data[size - 1] = c;
+    data[size] = '\0';
+    str->buffer.size = size + 1;
+    str->hash = 0;
+    str_text_append(str, data + size - 1, 1);
 }
 
-void string_insert_char(String* str, size_t i, char c)
+void string_vappendf(String* str, const char* fmt, va_list args)
 {
-    if (!str) {
-        printf("str insert char: str is null\n");
+    if (GENVEC_UNLIKELY(!str || !fmt)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str appendf: invalid parameters");
         return;
-    } 
-    if (i >= string_len(str)) {
-        string_append_char(str, c); // this will ensure null term at end
+    }
+    if (str_own(str) != 0) { return; }
+
+    // try to format into the spare capacity first, most appends fit
+    size_t len = string_len(str);
+    size_t room = str->buffer.capacity - len;   // counts the terminator slot
+
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(str_data(str) + len, room, fmt, copy);
+    va_end(copy);
+
+    if (GENVEC_UNLIKELY(n < 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "str appendf: format error");
+        str_data(str)[len] = '\0';
         return;
-    } 
-    
-    genVec_insert(str->buffer, i, (u8*)&c); 
-    ensure_null_terminated(str);
+    }
+
+    if ((size_t)n >= room) {
+        // didn't fit, now we know the exact size so this is a single grow
+        if (str_reserve(str, len + (size_t)n) != 0) {
+            str_data(str)[len] = '\0';
+            return;
+        }
+        vsnprintf(str_data(str) + len, (size_t)n + 1, fmt, args);
+    }
+
+    GENVEC_STAT_STRING(&str->buffer, GENVEC_EV_STR_APPEND, (size_t)n);
+    str_set_len(str, len + (size_t)n);
+    str_text_append(str, str_data(str) + len, (size_t)n);
 }
 
+void string_appendf(String* str, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    string_vappendf(str, fmt, args);
+    va_end(args);
+}
 
-void string_insert_cstr(String* str, size_t i, const char* cstr)
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// writes v backwards ending at end, two digits per step, returns the first char
+static char* str_write_u64(char* end, unsigned long long v)
 {
-    if (!str) {
-        printf("str insert cstr: str is null\n");
+    while (v >= 100) {
+        unsigned idx = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--end = digit_pairs[idx + 1];
+        *--end = digit_pairs[idx];
+    }
+    if (v >= 10) {
+        unsigned idx = (unsigned)v * 2;
+        *--end = digit_pairs[idx + 1];
+        *--end = digit_pairs[idx];
+    } else {
+        *--end = (char)('0' + v);
+    }
+    return end;
+}
+
+void string_append_uint(String* str, unsigned long long v)
+{
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str append uint: str null");
         return;
     }
-    if (i >= string_len(str)) {
-        string_append_cstr(str, cstr); // null term garenteed
+
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* start = str_write_u64(end, v);
+    str_append_bytes(str, start, (size_t)(end - start));
+}
+
+void string_append_int(String* str, long long v)
+{
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str append int: str null");
         return;
     }
-    
-    genVec_insert_multi(str->buffer, i, (u8*)cstr, strlen(cstr));
-    ensure_null_terminated(str);
+
+    // negate as unsigned so LLONG_MIN doesn't overflow
+    unsigned long long mag = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* start = str_write_u64(end, mag);
+    if (v < 0) { *--start = '-'; }
+    str_append_bytes(str, start, (size_t)(end - start));
 }
 
-void string_insert_string(String* str, size_t i, String* other)
+void string_append_double(String* str, double v, int decimals)
 {
-    if (!str || !other) {
-        printf("str insert str: parameters null\n");
+    static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str append double: str null");
         return;
     }
-    if (i >= string_len(str)) {
-        string_append_string(str, other);
+    if (decimals < 0) { decimals = 0; }
+    if (decimals > 9) { decimals = 9; }
+
+    int neg = signbit(v) != 0;
+    double mag = neg ? -v : v;
+    double scaled = mag * pow10[decimals] + 0.5;
+
+    // nan, inf and values too big for the integer path go through printf
+    if (!(scaled < 9.2e18)) {
+        string_appendf(str, "%.*f", decimals, v);
         return;
     }
-    
-    // is this right???
-    genVec_insert_multi(str->buffer, i, other->buffer->data, strlen(string_to_cstr(other)));
-    ensure_null_terminated(str);
+
+    unsigned long long fixed = (unsigned long long)scaled;
+    unsigned long long p = (unsigned long long)pow10[decimals];
+
+    char buf[48];
+    char* end = buf + sizeof(buf);
+    char* start = end;
+
+    if (decimals > 0) {
+        unsigned long long frac = fixed % p;
+        char* frac_start = str_write_u64(end, frac);
+        // pad the fraction with leading zeros to the full width
+        while (end - frac_start < decimals) { *--frac_start = '0'; }
+        start = frac_start;
+        *--start = '.';
+    }
+
+    start = str_write_u64(start, fixed / p);
+    if (neg) { *--start = '-'; }   // like printf, -0.001 gives "-0.00"
+    str_append_bytes(str, start, (size_t)(end - start));
+}
+
+void string_insert_char(String* str, size_t i, char c)
+{
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str insert char: str is null");
+        return;
+    }
+
+    size_t len = string_len(str);
+    if (i > len) { i = len; } // past the end appends
+
+    str_insert_bytes(str, i, &c, 1);
+}
+
+
+void string_insert_cstr(String* str, size_t i, const char* cstr)
+{
+    if (GENVEC_UNLIKELY(!str || !cstr)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str insert cstr: str is null");
+        return;
+    }
+
+    size_t len = string_len(str);
+    if (i > len) { i = len; }
+
+    str_insert_bytes(str, i, cstr, strlen(cstr));
+}
+
+void string_insert_string(String* str, size_t i, String* other)
+{
+    if (GENVEC_UNLIKELY(!str || !other)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str insert str: parameters null");
+        return;
+    }
+
+    size_t len = string_len(str);
+    if (i > len) { i = len; }
+
+    str_insert_bytes(str, i, str_data(other), string_len(other));
 }
 
 
 void string_remove_char(String* str, size_t i) {
-    if (!str || !str->buffer) { 
-        printf("str remove char: str or buffer null\n");
-        return; 
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str remove char: str or buffer null");
+        return;
     }
-    if (i >= string_len(str)) {
-        printf("str remove char: index out of bounds\n");
+
+    size_t len = string_len(str);
+    if (GENVEC_UNLIKELY(i >= len)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "str remove char: index out of bounds");
         return;
     }
-    
-    // Remove the character at index i
-    genVec_remove(str->buffer, i);
-    
-    // The null terminator should still be there, but im scared
-    ensure_null_terminated(str);
+    if (str_own(str) != 0) { return; }
+
+    // shift the tail (including null terminator) left by one
+    char* data = str_data(str);
+    unsigned char removed = (unsigned char)data[i];
+    memmove(data + i, data + i + 1, len - i);
+    GENVEC_STAT_MOVE(&str->buffer, len - i);
+
+    str_set_len(str, len - 1);
+
+    // taking out an ascii byte can't break valid text, anything else might (or might fix it)
+    if (removed >= 0x80 || !str_text_valid(str->text)) { str->text = STR_TEXT_UNKNOWN; }
 }
 
 void string_clear(String* str) {
-    if (!str) { 
-        printf("str clear: str null\n");
-        return; 
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str clear: str null");
+        return;
     }
-    
-    genVec_clear(str->buffer);
-    ensure_null_terminated(str);
+
+    // a shared buffer is dropped instead of copied, otherwise keep the capacity around for reuse
+    if (genVec_is_shared(&str->buffer)) { string_destroy_fromstk(str); }
+    str_set_len(str, 0);
+    str->text = STR_TEXT_ASCII;
 }
 
 char string_at(const String* str, size_t i) {
-    if (!str || i >= string_len(str)) { 
-        printf("str at: str null or i out of bounds\n");
-        return '\0'; 
+    if (GENVEC_UNLIKELY(!str || i >= string_len(str))) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "str at: str null or i out of bounds");
+        return '\0';
     }
-    
-    char c;
-    genVec_get(str->buffer, i, (u8*)&c);
-    return c;
+
+    return str_data(str)[i];
 }
 
 void string_set_char(String* str, size_t i, char c) {
-    if (!str || i >= string_len(str)) { 
-        printf("str set char: str null or i out of bounds\n");
-        return; 
+    if (GENVEC_UNLIKELY(!str || i >= string_len(str))) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "str set char: str null or i out of bounds");
+        return;
     }
-    genVec_replace(str->buffer, i, (u8*)&c);
+    if (str_own(str) != 0) { return; }
+
+    // ascii over ascii keeps the encoding state
+    char* data = str_data(str);
+    if (((unsigned char)data[i] | (unsigned char)c) >= 0x80) { str->text = STR_TEXT_UNKNOWN; }
+    data[i] = c;
+    str->hash = 0;
 }
 
 int string_compare(const String* str1, const String* str2) {
-    if (!str1 || !str2) { 
-        printf("str comp: parameters null\n");
-        return -1; 
+    if (GENVEC_UNLIKELY(!str1 || !str2)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str comp: parameters null");
+        return -1;
     }
-    return strcmp(string_to_cstr(str1), string_to_cstr(str2));
+
+    // lengths are known, so no scanning for the null terminator
+    size_t len1 = string_len(str1);
+    size_t len2 = string_len(str2);
+
+    int cmp = memcmp(str_data(str1), str_data(str2), len1 < len2 ? len1 : len2);
+    if (cmp != 0) { return cmp; }
+
+    return (len1 > len2) - (len1 < len2);
 }
 
 int string_equals(const String* str1, const String* str2) {
-    return string_compare(str1, str2) == 0;
+    if (!str1 || !str2) { return 0; }
+
+    // different lengths can never be equal, only compare bytes if they match
+    size_t len = string_len(str1);
+    return len == string_len(str2) && str_simd_equal(str_data(str1), str_data(str2), len);
 }
 
 int string_equals_cstr(const String* str, const char* cstr) {
@@ -277,55 +724,232 @@ int string_equals_cstr(const String* str, const char* cstr) {
     return strcmp(string_to_cstr(str), cstr) == 0;
 }
 
+uint64_t string_hash(const String* str)
+{
+    if (!str) { return 0; }
+    if (str->hash != 0) { return str->hash; }
+
+    // 0 marks "not computed", so a real 0 is stored as 1
+    uint64_t h = hash_bytes(str_data(str), string_len(str), HASH_DEFAULT_SEED);
+    if (h == 0) { h = 1; }
+
+    // the cache is not part of the value, so const callers can fill it
+    ((String*)str)->hash = h;
+    return h;
+}
+
+uint64_t string_hash_seed(const String* str, uint64_t seed) {
+    if (!str) { return 0; }
+    return hash_bytes(str_data(str), string_len(str), seed);
+}
+
 int string_find_char(const String* str, char c) {
     if (!str) { return -1; }
-    
-    const char* cstr = string_to_cstr(str);
-    const char* found = strchr(cstr, c);
-    return found ? found - cstr : -1;
+
+    // + 1 so that searching for '\0' finds the terminator, like strchr
+    size_t found = str_simd_find_char(str_data(str), string_len(str) + 1, c);
+    return found != STR_NPOS ? (int)found : -1;
 }
 
 int string_find_cstr(const String* str, const char* substr) {
     if (!str || !substr) { return -1; }
-    
-    const char* cstr = string_to_cstr(str);
-    const char* found = strstr(cstr, substr);
-    return found ? found - cstr : -1;
+
+    size_t found = str_simd_find(str_data(str), string_len(str), substr, strlen(substr));
+    return found != STR_NPOS ? (int)found : -1;
 }
 
-String* string_substr(const String* str, size_t start, size_t length) 
+String* string_substr(const String* str, size_t start, size_t length)
 {
     if (!str || start >= string_len(str)) { return NULL; }
-    
-    String* result = string_create();
+
+    String* result = string_create_alloc(str->buffer.alloc);
     if (!result) { return NULL; }
-    
+
     size_t end = start + length;
     size_t str_len = string_len(str);
-    if (end > str_len) {
+    if (end > str_len || end < start) {
         end = str_len;
     }
-    
-    size_t actual_len = end - start;
-    if (actual_len > 0) {
-        // Remove null terminator from result
-        if (result->buffer->size > 0) {
-            result->buffer->size--;
-        }
-        
-        // Insert substring all at once
-        const char* src = string_to_cstr(str) + start;
-        genVec_insert_multi(result->buffer, 0, (const u8*)src, actual_len);
-        
-        ensure_null_terminated(result);
-    }
+
+    // copy the substring all at once
+    str_append_bytes(result, str_data(str) + start, end - start);
     return result;
 }
 
+int string_is_ascii(const String* str) {
+    return str ? str_text(str) == STR_TEXT_ASCII : 0;
+}
+
+int string_is_utf8(const String* str) {
+    return str ? str_text_valid(str_text(str)) : 0;
+}
+
+int string_utf8_next_multi(StringUtf8Iter* it, uint32_t* cp)
+{
+    if (it->pos >= it->len) { return 0; }
+
+    size_t n = str_utf8_decode(it->ptr + it->pos, it->len - it->pos, cp);
+    if (n == 0) {
+        *cp = 0xFFFD;   // replacement character, resync at the next byte
+        n = 1;
+    }
+    it->pos += n;
+    return 1;
+}
+
+size_t string_utf8_len(const String* str)
+{
+    if (!str) { return 0; }
+
+    switch (str_text(str)) {
+    case STR_TEXT_ASCII: return string_len(str);
+    case STR_TEXT_UTF8:  return str_simd_utf8_count(str_data(str), string_len(str));
+    default: break;
+    }
+
+    // malformed, step through it the way the iterator does
+    StringUtf8Iter it = string_utf8_iter(str);
+    uint32_t cp;
+    size_t count = 0;
+    while (string_utf8_next(&it, &cp)) { count++; }
+    return count;
+}
+
+// byte offset of code point n (or len if the string ends first), from byte pos on
+static size_t str_utf8_skip(StringUtf8Iter* it, size_t n)
+{
+    uint32_t cp;
+    while (n > 0 && string_utf8_next(it, &cp)) { n--; }
+    return it->pos;
+}
+
+String* string_utf8_substr(const String* str, size_t start_cp, size_t n_cp)
+{
+    if (!str) { return NULL; }
+
+    // ascii: code points are bytes
+    if (str_text(str) == STR_TEXT_ASCII) { return string_substr(str, start_cp, n_cp); }
+
+    StringUtf8Iter it = string_utf8_iter(str);
+    size_t start = str_utf8_skip(&it, start_cp);
+    if (start >= it.len) { return NULL; }
+    size_t end = str_utf8_skip(&it, n_cp);
+
+    return string_substr(str, start, end - start);
+}
+
 void string_print(const String* str) {
     if (str) {
         printf("\"%s\"", string_to_cstr(str));
     }
 }
 
+int string_read_line(String* str, FILE* f)
+{
+    if (GENVEC_UNLIKELY(!str || !f)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str read line: str or file is null");
+        return -1;
+    }
+
+    // the contents get replaced, so a shared buffer isn't worth copying
+    if (genVec_is_shared(&str->buffer)) { string_destroy_fromstk(str); }
+    str->text = STR_TEXT_UNKNOWN;
+
+    size_t len = 0;
+    int c;
+
+    // one stream lock for the whole line, chars go straight into the buffer
+    flockfile(f);
+    while ((c = getc_unlocked(f)) != EOF && c != '\n') {
+        if (len + 2 > str->buffer.capacity) {
+            str_set_len(str, len);      // so moving off sso copies what we have
+            if (str_reserve(str, len + 1) != 0) {
+                funlockfile(f);
+                return -1;
+            }
+        }
+        str_data(str)[len++] = (char)c;
+    }
+    funlockfile(f);
+
+    str_set_len(str, len);
+
+    if (GENVEC_UNLIKELY(ferror(f))) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "str read line: read error");
+        return -1;
+    }
+    if (c == EOF && len == 0) {
+        GENVEC_FAIL_QUIET(GENVEC_ERR_EMPTY);
+        return -1;
+    }
+    return 0;
+}
+
+int string_read_file(String* str, const char* path)
+{
+    if (GENVEC_UNLIKELY(!str || !path)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str read file: str or path is null");
+        return -1;
+    }
+
+    FILE* f = fopen(path, "rb");
+    if (GENVEC_UNLIKELY(!f)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "str read file: can't open file");
+        return -1;
+    }
+
+    string_clear(str);
+    str->text = STR_TEXT_UNKNOWN;
+
+    // regular files: size it up front with one spare byte, so the first fread
+    // comes back short and we never grow. Pipes and such just grow as they go.
+    if (fseek(f, 0, SEEK_END) == 0) {
+        long size = ftell(f);
+        if (size > 0 && str_reserve(str, (size_t)size + 1) != 0) {
+            fclose(f);
+            return -1;
+        }
+        rewind(f);
+    }
+
+    size_t len = 0;
+    for (;;) {
+        if (len + 2 > str->buffer.capacity) {
+            str_set_len(str, len);
+            if (str_reserve(str, len + 1) != 0) {
+                fclose(f);
+                return -1;
+            }
+        }
+
+        size_t room = str->buffer.capacity - len - 1;
+        size_t n = fread(str_data(str) + len, 1, room, f);
+        len += n;
+        if (n < room) { break; }
+    }
+
+    str_set_len(str, len);
+
+    int err = ferror(f);
+    fclose(f);
+    if (GENVEC_UNLIKELY(err)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "str read file: read error");
+        return -1;
+    }
+    return 0;
+}
+
+int string_write(const String* str, FILE* f)
+{
+    if (GENVEC_UNLIKELY(!str || !f)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "str write: str or file is null");
+        return -1;
+    }
 
+    size_t len = string_len(str);
+    if (GENVEC_UNLIKELY(len && fwrite(str_data(str), 1, len, f) != len)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "str write: write failed");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "StringPool.h"
+#include "genvec_diag.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// Private helpers
+
+// a String header over sv's bytes for lookups, never mutated or destroyed.
+// Only length, bytes and hash are read, so sv needn't be null terminated.
+static void pool_probe(String* probe, StringView sv)
+{
+    probe->buffer.data = (u8*)(sv.ptr ? sv.ptr : "");
+    probe->buffer.size = sv.len + 1;
+    probe->buffer.capacity = sv.len + 1;
+    probe->buffer.data_size = sizeof(char);
+    probe->buffer.del_fn = NULL;
+    probe->buffer.alloc = NULL;
+    probe->buffer.policy = NULL;
+    probe->buffer.flags = GENVEC_EXTERNAL;
+    probe->hash = 0;
+    probe->text = 0;
+}
+
+static const String* pool_lookup(const StringPool* pool, const String* key)
+{
+    u8* slot = hashmap_get(pool->index, (const u8*)&key);
+    return slot ? *(const String**)slot : NULL;
+}
+
+
+StringPool* strpool_create(void)
+{
+    StringPool* pool = malloc(sizeof(StringPool));
+    if (GENVEC_UNLIKELY(!pool)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "strpool create: malloc failed");
+        return NULL;
+    }
+
+    pool->arena = arena_create(0);
+    pool->index = hashmap_create(sizeof(String*), 0, hashmap_string_hash, hashmap_string_eq, NULL, NULL);
+    if (GENVEC_UNLIKELY(!pool->arena || !pool->index)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "strpool create: arena or index failed");
+        arena_destroy(pool->arena);
+        hashmap_destroy(pool->index);
+        free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void strpool_destroy(StringPool* pool)
+{
+    if (!pool) { return; }
+
+    // all the interned strings go away with the arena
+    hashmap_destroy(pool->index);
+    arena_destroy(pool->arena);
+    free(pool);
+}
+
+const String* strpool_intern_view(StringPool* pool, StringView sv)
+{
+    if (GENVEC_UNLIKELY(!pool || (!sv.ptr && sv.len > 0))) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "strpool intern: invalid parameters");
+        return NULL;
+    }
+
+    String probe;
+    pool_probe(&probe, sv);
+
+    const String* found = pool_lookup(pool, &probe);
+    if (found) { return found; }
+
+    // first sight: header and (if it doesn't fit inline) the chars go in the arena
+    int inline_chars = sv.len + 1 <= STRING_SSO_SIZE;
+    size_t bytes = sizeof(String) + (inline_chars ? 0 : sv.len + 1);
+
+    String* str = arena_alloc(pool->arena, bytes);
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "strpool intern: arena alloc failed");
+        return NULL;
+    }
+
+    char* chars = inline_chars ? str->sso : (char*)(str + 1);
+    if (sv.len > 0) { memcpy(chars, sv.ptr, sv.len); }
+    chars[sv.len] = '\0';
+
+    // the buffer is external, so nothing ever tries to free it
+    genVec_init_buffer(&str->buffer, (u8*)chars, sv.len + 1, sizeof(char), NULL);
+    str->buffer.size = sv.len + 1;
+    str->hash = string_hash(&probe);   // already computed by the lookup
+    str->text = 0;                     // worked out on the first UTF-8 query
+
+    if (GENVEC_UNLIKELY(hashmap_insert(pool->index, (const u8*)&str, NULL) < 0)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "strpool intern: index insert failed");
+        return NULL;
+    }
+
+    return str;
+}
+
+const String* strpool_intern_cstr(StringPool* pool, const char* cstr)
+{
+    if (GENVEC_UNLIKELY(!cstr)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "strpool intern cstr: cstr is null");
+        return NULL;
+    }
+    return strpool_intern_view(pool, sv_make(cstr, strlen(cstr)));
+}
+
+const String* strpool_intern(StringPool* pool, const String* str)
+{
+    if (GENVEC_UNLIKELY(!str)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "strpool intern str: str is null");
+        return NULL;
+    }
+    return strpool_intern_view(pool, string_view_of(str));
+}
+
+const String* strpool_find_view(const StringPool* pool, StringView sv)
+{
+    if (!pool || (!sv.ptr && sv.len > 0)) { return NULL; }
+
+    String probe;
+    pool_probe(&probe, sv);
+    return pool_lookup(pool, &probe);
+}
+
+const String* strpool_find_cstr(const StringPool* pool, const char* cstr)
+{
+    if (!cstr) { return NULL; }
+    return strpool_find_view(pool, sv_make(cstr, strlen(cstr)));
+}
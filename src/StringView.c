@@ -0,0 +1,106 @@
+#include "StringView.h"
+#include "string_simd.h"
+#include "genvec_diag.h"
+
+#include <string.h>
+
+
+static inline int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+StringView sv_from_cstr(const char* cstr) {
+    if (GENVEC_UNLIKELY(!cstr)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "sv from cstr: cstr is null");
+        return sv_make(NULL, 0);
+    }
+    return sv_make(cstr, strlen(cstr));
+}
+
+StringView sv_substr(StringView sv, size_t start, size_t len)
+{
+    if (!sv.ptr) { return sv; }
+    if (start >= sv.len) { return sv_make(sv.ptr + sv.len, 0); }
+
+    if (len > sv.len - start) { len = sv.len - start; }
+    return sv_make(sv.ptr + start, len);
+}
+
+StringView sv_trim_left(StringView sv) {
+    while (sv.len > 0 && is_space(sv.ptr[0])) {
+        sv.ptr++;
+        sv.len--;
+    }
+    return sv;
+}
+
+StringView sv_trim_right(StringView sv) {
+    while (sv.len > 0 && is_space(sv.ptr[sv.len - 1])) {
+        sv.len--;
+    }
+    return sv;
+}
+
+StringView sv_trim(StringView sv) {
+    return sv_trim_right(sv_trim_left(sv));
+}
+
+int sv_find_char(StringView sv, char c) {
+    if (!sv.ptr) { return -1; }
+
+    size_t found = str_simd_find_char(sv.ptr, sv.len, c);
+    return found != STR_NPOS ? (int)found : -1;
+}
+
+int sv_find(StringView sv, StringView needle) {
+    if (!sv.ptr || (!needle.ptr && needle.len > 0)) { return -1; }
+
+    size_t found = str_simd_find(sv.ptr, sv.len, needle.ptr, needle.len);
+    return found != STR_NPOS ? (int)found : -1;
+}
+
+int sv_equals(StringView a, StringView b) {
+    if (a.len != b.len) { return 0; }
+    if (a.len == 0) { return 1; }
+
+    return str_simd_equal(a.ptr, b.ptr, a.len);
+}
+
+int sv_equals_cstr(StringView sv, const char* cstr) {
+    if (!cstr) { return 0; }
+
+    // stop at the first mismatch instead of strlen'ing all of cstr first
+    for (size_t i = 0; i < sv.len; i++) {
+        if (cstr[i] != sv.ptr[i] || cstr[i] == '\0') { return 0; }
+    }
+    return cstr[sv.len] == '\0';
+}
+
+int sv_starts_with(StringView sv, StringView prefix) {
+    if (prefix.len > sv.len) { return 0; }
+    if (prefix.len == 0) { return 1; }
+
+    return str_simd_equal(sv.ptr, prefix.ptr, prefix.len);
+}
+
+int sv_split_next(StringView* rest, char delim, StringView* token)
+{
+    if (GENVEC_UNLIKELY(!rest || !token)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "sv split: rest or token is null");
+        return 0;
+    }
+    // ptr == NULL marks a rest that has been used up
+    if (!rest->ptr) { return 0; }
+
+    size_t found = str_simd_find_char(rest->ptr, rest->len, delim);
+    if (found == STR_NPOS) {
+        *token = *rest;
+        *rest = sv_make(NULL, 0);
+        return 1;
+    }
+
+    *token = sv_make(rest->ptr, found);
+    rest->ptr += found + 1;
+    rest->len -= found + 1;
+    return 1;
+}
@@ -0,0 +1,416 @@
+#include "allocator.h"
+#include "genvec_diag.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#define ALIGN_UP(n) (((n) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+
+
+struct arena_block {
+    arena_block* next;
+    size_t cap;
+    size_t used;
+};
+
+struct pool_chunk {
+    pool_chunk* next;
+};
+
+// header in front of a request bigger than block_size, so reset/destroy can find it
+struct pool_big {
+    pool_big* prev;
+    pool_big* next;
+};
+
+// block/chunk data starts right after the (aligned) header
+#define ARENA_HDR ALIGN_UP(sizeof(arena_block))
+#define POOL_HDR ALIGN_UP(sizeof(pool_chunk))
+#define POOL_BIG_HDR ALIGN_UP(sizeof(pool_big))
+
+// biggest arena request: aligning it up and adding the block header can't wrap
+#define ARENA_MAX_ALLOC (SIZE_MAX - ARENA_HDR - ARENA_ALIGN)
+
+static inline u8* block_data(arena_block* b) {
+    return (u8*)b + ARENA_HDR;
+}
+
+//private functions
+static void* arena_vt_alloc(void* ctx, size_t size);
+static void* arena_vt_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size);
+static void arena_vt_free(void* ctx, void* ptr, size_t size);
+static void* pool_vt_alloc(void* ctx, size_t size);
+static void* pool_vt_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size);
+static void pool_vt_free(void* ctx, void* ptr, size_t size);
+
+
+static arena_block* arena_block_new(size_t cap) {
+    arena_block* b = malloc(ARENA_HDR + cap);
+    if (!b) { return NULL; }
+
+    b->next = NULL;
+    b->cap = cap;
+    b->used = 0;
+    return b;
+}
+
+Arena* arena_create(size_t block_size)
+{
+    Arena* arena = malloc(sizeof(Arena));
+    if (GENVEC_UNLIKELY(!arena)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "arena create: malloc failed");
+        return NULL;
+    }
+
+    if (GENVEC_UNLIKELY(block_size > ARENA_MAX_ALLOC)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "arena create: block size too big");
+        free(arena);
+        return NULL;
+    }
+
+    // blocks are only allocated on first use
+    arena->first = NULL;
+    arena->head = NULL;
+    arena->block_size = block_size ? ALIGN_UP(block_size) : ARENA_DEFAULT_BLOCK;
+
+    arena->allocator.alloc = arena_vt_alloc;
+    arena->allocator.realloc = arena_vt_realloc;
+    arena->allocator.free = arena_vt_free;
+    arena->allocator.ctx = arena;
+
+    return arena;
+}
+
+void arena_destroy(Arena* arena)
+{
+    if (GENVEC_UNLIKELY(!arena)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "arena destroy: arena is null");
+        return;
+    }
+
+    arena_block* b = arena->first;
+    while (b) {
+        arena_block* next = b->next;
+        free(b);
+        b = next;
+    }
+    free(arena);
+}
+
+void arena_reset(Arena* arena)
+{
+    if (GENVEC_UNLIKELY(!arena)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "arena reset: arena is null");
+        return;
+    }
+
+    // later blocks get their used reset when we bump into them again
+    arena->head = arena->first;
+    if (arena->head) { arena->head->used = 0; }
+}
+
+void* arena_alloc(Arena* arena, size_t size)
+{
+    if (GENVEC_UNLIKELY(!arena)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "arena alloc: arena is null");
+        return NULL;
+    }
+
+    if (GENVEC_UNLIKELY(size > ARENA_MAX_ALLOC)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "arena alloc: size too big");
+        return NULL;
+    }
+
+    size = ALIGN_UP(size);
+    size_t new_cap = size > arena->block_size ? size : arena->block_size;
+
+    if (!arena->first) {
+        arena->first = arena_block_new(new_cap);
+        if (GENVEC_UNLIKELY(!arena->first)) {
+            GENVEC_FAIL(GENVEC_ERR_ALLOC, "arena alloc: block malloc failed");
+            return NULL;
+        }
+        arena->head = arena->first;
+    }
+
+    // move on to the next kept block (or a new one) until it fits
+    arena_block* b = arena->head;
+    while (b->cap - b->used < size) {
+        if (!b->next) {
+            b->next = arena_block_new(new_cap);
+            if (GENVEC_UNLIKELY(!b->next)) {
+                GENVEC_FAIL(GENVEC_ERR_ALLOC, "arena alloc: block malloc failed");
+                return NULL;
+            }
+        }
+        b = b->next;
+        b->used = 0;
+    }
+    arena->head = b;
+
+    void* ptr = block_data(b) + b->used;
+    b->used += size;
+    return ptr;
+}
+
+const genVec_allocator* arena_allocator(Arena* arena) {
+    return arena ? &arena->allocator : NULL;
+}
+
+static void* arena_vt_alloc(void* ctx, size_t size) {
+    return arena_alloc((Arena*)ctx, size);
+}
+
+static void* arena_vt_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size)
+{
+    Arena* arena = ctx;
+    if (!ptr) { return arena_alloc(arena, new_size); }
+    if (GENVEC_UNLIKELY(new_size > ARENA_MAX_ALLOC)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "arena realloc: size too big");
+        return NULL;
+    }
+
+    // the last allocation in the head block can be resized in place
+    arena_block* b = arena->head;
+    size_t old_r = ALIGN_UP(old_size);
+    if (b && block_data(b) + b->used == (u8*)ptr + old_r) {
+        size_t start = b->used - old_r;
+        if (start + ALIGN_UP(new_size) <= b->cap) {
+            b->used = start + ALIGN_UP(new_size);
+            return ptr;
+        }
+    }
+    if (new_size <= old_size) { return ptr; }
+
+    void* new_ptr = arena_alloc(arena, new_size);
+    if (!new_ptr) { return NULL; }
+
+    memcpy(new_ptr, ptr, old_size);
+    return new_ptr;
+}
+
+static void arena_vt_free(void* ctx, void* ptr, size_t size)
+{
+    Arena* arena = ctx;
+
+    // only the last allocation can be given back, the rest waits for reset
+    arena_block* b = arena->head;
+    size_t r = ALIGN_UP(size);
+    if (b && ptr && block_data(b) + b->used == (u8*)ptr + r) {
+        b->used -= r;
+    }
+}
+
+
+// oversized requests: malloc'd with a pool_big header, linked into pool->big
+
+static void* pool_big_alloc(Pool* pool, size_t size)
+{
+    if (GENVEC_UNLIKELY(size > SIZE_MAX - POOL_BIG_HDR)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "pool alloc: size too big");
+        return NULL;
+    }
+
+    pool_big* b = malloc(POOL_BIG_HDR + size);
+    if (GENVEC_UNLIKELY(!b)) { return NULL; }
+
+    b->prev = NULL;
+    b->next = pool->big;
+    if (pool->big) { pool->big->prev = b; }
+    pool->big = b;
+    return (u8*)b + POOL_BIG_HDR;
+}
+
+static void* pool_big_realloc(Pool* pool, void* ptr, size_t new_size)
+{
+    if (GENVEC_UNLIKELY(new_size > SIZE_MAX - POOL_BIG_HDR)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "pool realloc: size too big");
+        return NULL;
+    }
+
+    pool_big* b = realloc((u8*)ptr - POOL_BIG_HDR, POOL_BIG_HDR + new_size);
+    if (GENVEC_UNLIKELY(!b)) { return NULL; }
+
+    // the block may have moved, fix up its neighbours
+    if (b->prev) { b->prev->next = b; }
+    else         { pool->big = b; }
+    if (b->next) { b->next->prev = b; }
+    return (u8*)b + POOL_BIG_HDR;
+}
+
+static void pool_big_free(Pool* pool, void* ptr)
+{
+    if (!ptr) { return; }
+
+    pool_big* b = (pool_big*)((u8*)ptr - POOL_BIG_HDR);
+    if (b->prev) { b->prev->next = b->next; }
+    else         { pool->big = b->next; }
+    if (b->next) { b->next->prev = b->prev; }
+    free(b);
+}
+
+static void pool_big_free_all(Pool* pool)
+{
+    pool_big* b = pool->big;
+    while (b) {
+        pool_big* next = b->next;
+        free(b);
+        b = next;
+    }
+    pool->big = NULL;
+}
+
+
+Pool* pool_create(size_t block_size, size_t blocks_per_chunk)
+{
+    if (GENVEC_UNLIKELY(block_size == 0 || blocks_per_chunk == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "pool create: block size and count can't be 0");
+        return NULL;
+    }
+
+    // a chunk is POOL_HDR + block_size * blocks_per_chunk, that can't wrap either
+    if (GENVEC_UNLIKELY(block_size > ARENA_MAX_ALLOC ||
+                        blocks_per_chunk > (SIZE_MAX - POOL_HDR) / ALIGN_UP(block_size))) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "pool create: chunk size too big");
+        return NULL;
+    }
+
+    Pool* pool = malloc(sizeof(Pool));
+    if (GENVEC_UNLIKELY(!pool)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "pool create: malloc failed");
+        return NULL;
+    }
+
+    // a free block has to hold the free list link
+    if (block_size < sizeof(void*)) { block_size = sizeof(void*); }
+
+    pool->block_size = ALIGN_UP(block_size);
+    pool->blocks_per_chunk = blocks_per_chunk;
+    pool->free_list = NULL;
+    pool->first = NULL;
+    pool->head = NULL;
+    pool->head_used = 0;
+    pool->big = NULL;
+
+    pool->allocator.alloc = pool_vt_alloc;
+    pool->allocator.realloc = pool_vt_realloc;
+    pool->allocator.free = pool_vt_free;
+    pool->allocator.ctx = pool;
+
+    return pool;
+}
+
+void pool_destroy(Pool* pool)
+{
+    if (GENVEC_UNLIKELY(!pool)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "pool destroy: pool is null");
+        return;
+    }
+
+    pool_big_free_all(pool);
+
+    pool_chunk* c = pool->first;
+    while (c) {
+        pool_chunk* next = c->next;
+        free(c);
+        c = next;
+    }
+    free(pool);
+}
+
+void pool_reset(Pool* pool)
+{
+    if (GENVEC_UNLIKELY(!pool)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "pool reset: pool is null");
+        return;
+    }
+
+    pool_big_free_all(pool);
+
+    pool->free_list = NULL;
+    pool->head = pool->first;
+    pool->head_used = 0;
+}
+
+void* pool_alloc(Pool* pool)
+{
+    if (GENVEC_UNLIKELY(!pool)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "pool alloc: pool is null");
+        return NULL;
+    }
+
+    // reuse freed blocks first
+    if (pool->free_list) {
+        void* block = pool->free_list;
+        pool->free_list = *(void**)block;
+        return block;
+    }
+
+    if (!pool->head || pool->head_used == pool->blocks_per_chunk)
+    {
+        pool_chunk* next = pool->head ? pool->head->next : pool->first;
+        if (!next) {
+            next = malloc(POOL_HDR + pool->block_size * pool->blocks_per_chunk);
+            if (GENVEC_UNLIKELY(!next)) {
+                GENVEC_FAIL(GENVEC_ERR_ALLOC, "pool alloc: chunk malloc failed");
+                return NULL;
+            }
+            next->next = NULL;
+
+            if (pool->head) { pool->head->next = next; }
+            else            { pool->first = next; }
+        }
+        pool->head = next;
+        pool->head_used = 0;
+    }
+
+    u8* block = (u8*)pool->head + POOL_HDR + pool->head_used * pool->block_size;
+    pool->head_used++;
+    return block;
+}
+
+void pool_free(Pool* pool, void* block)
+{
+    if (!pool || !block) { return; }
+
+    *(void**)block = pool->free_list;
+    pool->free_list = block;
+}
+
+const genVec_allocator* pool_allocator(Pool* pool) {
+    return pool ? &pool->allocator : NULL;
+}
+
+static void* pool_vt_alloc(void* ctx, size_t size)
+{
+    Pool* pool = ctx;
+    return size <= pool->block_size ? pool_alloc(pool) : pool_big_alloc(pool, size);
+}
+
+static void* pool_vt_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size)
+{
+    Pool* pool = ctx;
+    if (!ptr) { return pool_vt_alloc(pool, new_size); }
+
+    int old_small = old_size <= pool->block_size;
+    int new_small = new_size <= pool->block_size;
+
+    if (old_small && new_small) { return ptr; }
+    if (!old_small && !new_small) { return pool_big_realloc(pool, ptr, new_size); }
+
+    // moving between a pool block and an oversized one
+    void* new_ptr = pool_vt_alloc(pool, new_size);
+    if (!new_ptr) { return NULL; }
+
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    pool_vt_free(pool, ptr, old_size);
+    return new_ptr;
+}
+
+static void pool_vt_free(void* ctx, void* ptr, size_t size)
+{
+    Pool* pool = ctx;
+    if (size <= pool->block_size) { pool_free(pool, ptr); }
+    else                          { pool_big_free(pool, ptr); }
+}
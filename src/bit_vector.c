@@ -0,0 +1,452 @@
+#include "bit_vector.h"
+#include "genvec_diag.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__SSE2__))
+    #define BIT_SIMD_SSE2 1
+    #define BIT_SIMD_AVX2 1
+    #include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+    #define BIT_SIMD_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#define LOAD_FN(p) __atomic_load_n(&(p), __ATOMIC_RELAXED)
+#define STORE_FN(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELAXED)
+
+
+typedef enum { BIT_AND, BIT_OR, BIT_XOR, BIT_ANDNOT, BIT_NOT } bit_op;
+
+typedef void (*bit_op_fn)(uint64_t* dst, const uint64_t* src, size_t n, bit_op op);
+typedef size_t (*bit_count_fn)(const uint64_t* w, size_t n);
+
+//private functions
+static void op_resolve(uint64_t* dst, const uint64_t* src, size_t n, bit_op op);
+static size_t count_resolve(const uint64_t* w, size_t n);
+
+// start out on the resolvers, which swap in the best kernel on first use
+static bit_op_fn op_impl = op_resolve;
+static bit_count_fn count_impl = count_resolve;
+
+
+// Kernels - word loops, src is unused for BIT_NOT
+
+static inline uint64_t word_op(uint64_t a, uint64_t b, bit_op op)
+{
+    switch (op) {
+        case BIT_AND:    return a & b;
+        case BIT_OR:     return a | b;
+        case BIT_XOR:    return a ^ b;
+        case BIT_ANDNOT: return a & ~b;
+        case BIT_NOT:    return ~a;
+    }
+    return a;
+}
+
+static void op_tail(uint64_t* dst, const uint64_t* src, size_t i, size_t n, bit_op op) {
+    for (; i < n; i++) { dst[i] = word_op(dst[i], op == BIT_NOT ? 0 : src[i], op); }
+}
+
+static inline size_t popcount_swar(uint64_t x)
+{
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (size_t)((x * 0x0101010101010101ull) >> 56);
+}
+
+static size_t count_swar(const uint64_t* w, size_t n)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) { total += popcount_swar(w[i]); }
+    return total;
+}
+
+
+#if !BIT_SIMD_SSE2 && !BIT_SIMD_NEON
+
+static void op_scalar(uint64_t* dst, const uint64_t* src, size_t n, bit_op op) {
+    op_tail(dst, src, 0, n, op);
+}
+
+#endif
+
+
+#if BIT_SIMD_SSE2
+
+static inline __m128i sse2_op(__m128i a, __m128i b, bit_op op)
+{
+    switch (op) {
+        case BIT_AND:    return _mm_and_si128(a, b);
+        case BIT_OR:     return _mm_or_si128(a, b);
+        case BIT_XOR:    return _mm_xor_si128(a, b);
+        case BIT_ANDNOT: return _mm_andnot_si128(b, a);
+        case BIT_NOT:    return _mm_xor_si128(a, _mm_set1_epi32(-1));
+    }
+    return a;
+}
+
+static void op_sse2(uint64_t* dst, const uint64_t* src, size_t n, bit_op op)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i b = op == BIT_NOT ? a : _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), sse2_op(a, b, op));
+    }
+    op_tail(dst, src, i, n, op);
+}
+
+// the popcnt instruction, 4 independent sums so they can issue back to back
+__attribute__((target("popcnt")))
+static size_t count_popcnt(const uint64_t* w, size_t n)
+{
+    size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        c0 += (size_t)__builtin_popcountll(w[i]);
+        c1 += (size_t)__builtin_popcountll(w[i + 1]);
+        c2 += (size_t)__builtin_popcountll(w[i + 2]);
+        c3 += (size_t)__builtin_popcountll(w[i + 3]);
+    }
+    for (; i < n; i++) { c0 += (size_t)__builtin_popcountll(w[i]); }
+    return c0 + c1 + c2 + c3;
+}
+
+#endif
+
+
+#if BIT_SIMD_AVX2
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_op(__m256i a, __m256i b, bit_op op)
+{
+    switch (op) {
+        case BIT_AND:    return _mm256_and_si256(a, b);
+        case BIT_OR:     return _mm256_or_si256(a, b);
+        case BIT_XOR:    return _mm256_xor_si256(a, b);
+        case BIT_ANDNOT: return _mm256_andnot_si256(b, a);
+        case BIT_NOT:    return _mm256_xor_si256(a, _mm256_set1_epi32(-1));
+    }
+    return a;
+}
+
+__attribute__((target("avx2")))
+static void op_avx2(uint64_t* dst, const uint64_t* src, size_t n, bit_op op)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i b = op == BIT_NOT ? a : _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), avx2_op(a, b, op));
+    }
+    op_tail(dst, src, i, n, op);
+}
+
+// nibble lookup through pshufb, byte counts summed per lane with sad (Mula's method)
+__attribute__((target("avx2,popcnt")))
+static size_t count_avx2(const uint64_t* w, size_t n)
+{
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(w + i));
+        __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low));
+        __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), zero));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    size_t total = (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    for (; i < n; i++) { total += (size_t)__builtin_popcountll(w[i]); }
+    return total;
+}
+
+#endif
+
+
+#if BIT_SIMD_NEON
+
+static inline uint64x2_t neon_op(uint64x2_t a, uint64x2_t b, bit_op op)
+{
+    switch (op) {
+        case BIT_AND:    return vandq_u64(a, b);
+        case BIT_OR:     return vorrq_u64(a, b);
+        case BIT_XOR:    return veorq_u64(a, b);
+        case BIT_ANDNOT: return vbicq_u64(a, b);
+        case BIT_NOT:    return veorq_u64(a, vdupq_n_u64(~(uint64_t)0));
+    }
+    return a;
+}
+
+static void op_neon(uint64_t* dst, const uint64_t* src, size_t n, bit_op op)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t a = vld1q_u64(dst + i);
+        uint64x2_t b = op == BIT_NOT ? a : vld1q_u64(src + i);
+        vst1q_u64(dst + i, neon_op(a, b, op));
+    }
+    op_tail(dst, src, i, n, op);
+}
+
+// per byte counts, 16 bytes sum to at most 128 so one horizontal add per vector
+static size_t count_neon(const uint64_t* w, size_t n)
+{
+    size_t total = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        total += vaddvq_u8(vcntq_u8(vreinterpretq_u8_u64(vld1q_u64(w + i))));
+    }
+    for (; i < n; i++) { total += popcount_swar(w[i]); }
+    return total;
+}
+
+#endif
+
+
+// pick the kernels for this cpu, every thread picks the same ones so racing is harmless
+static void bit_simd_resolve(void)
+{
+#if BIT_SIMD_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        STORE_FN(op_impl, op_avx2);
+        STORE_FN(count_impl, count_avx2);
+        return;
+    }
+#endif
+#if BIT_SIMD_SSE2
+    STORE_FN(op_impl, op_sse2);
+    STORE_FN(count_impl, __builtin_cpu_supports("popcnt") ? count_popcnt : count_swar);
+#elif BIT_SIMD_NEON
+    STORE_FN(op_impl, op_neon);
+    STORE_FN(count_impl, count_neon);
+#else
+    STORE_FN(op_impl, op_scalar);
+    STORE_FN(count_impl, count_swar);
+#endif
+}
+
+static void op_resolve(uint64_t* dst, const uint64_t* src, size_t n, bit_op op) {
+    bit_simd_resolve();
+    LOAD_FN(op_impl)(dst, src, n, op);
+}
+
+static size_t count_resolve(const uint64_t* w, size_t n) {
+    bit_simd_resolve();
+    return LOAD_FN(count_impl)(w, n);
+}
+
+
+// Private helpers
+
+// no n_bits + 63, that wraps for n_bits near SIZE_MAX
+static inline size_t bit_words_for(size_t n_bits) {
+    return n_bits / 64 + (n_bits % 64 != 0);
+}
+
+// zero the bits past n_bits in the last word, after anything that may set them
+static inline void bit_mask_tail(bitVec* bv)
+{
+    size_t rem = bv->n_bits & 63;
+    if (rem) { bitVec_words(bv)[bv->words.size - 1] &= ((uint64_t)1 << rem) - 1; }
+}
+
+static int bit_binary(bitVec* dst, const bitVec* src, bit_op op, const char* msg)
+{
+    if (GENVEC_UNLIKELY(!dst || !src)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, msg);
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(dst->n_bits != src->n_bits)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, msg);
+        return -1;
+    }
+
+    LOAD_FN(op_impl)(bitVec_words(dst), bitVec_words(src), dst->words.size, op);
+    return 0;
+}
+
+
+bitVec* bitVec_create(size_t n_bits)
+{
+    bitVec* bv = malloc(sizeof(bitVec));
+    if (GENVEC_UNLIKELY(!bv)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "bitVec create: malloc failed");
+        return NULL;
+    }
+
+    bv->n_bits = 0;
+    genVec_init_inplace(&bv->words, 0, sizeof(uint64_t), NULL);
+    if (bitVec_resize(bv, n_bits) != 0) {
+        genVec_deinit(&bv->words);
+        free(bv);
+        return NULL;
+    }
+    return bv;
+}
+
+bitVec* bitVec_copy(const bitVec* src)
+{
+    if (GENVEC_UNLIKELY(!src)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "bitVec copy: src is null");
+        return NULL;
+    }
+
+    bitVec* bv = bitVec_create(src->n_bits);
+    if (!bv) { return NULL; }
+    if (src->words.size) { memcpy(bv->words.data, src->words.data, src->words.size * sizeof(uint64_t)); }
+    return bv;
+}
+
+void bitVec_destroy(bitVec* bv)
+{
+    if (!bv) { return; }
+
+    genVec_deinit(&bv->words);
+    free(bv);
+}
+
+int bitVec_resize(bitVec* bv, size_t n_bits)
+{
+    if (GENVEC_UNLIKELY(!bv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "bitVec resize: bv is null");
+        return -1;
+    }
+
+    // new words come in zeroed, and the old tail bits already are
+    if (GENVEC_UNLIKELY(genVec_resize(&bv->words, bit_words_for(n_bits), NULL) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "bitVec resize: word allocation failed");
+        return -1;
+    }
+    bv->n_bits = n_bits;
+    bit_mask_tail(bv);
+    return 0;
+}
+
+int bitVec_push(bitVec* bv, int bit)
+{
+    if (GENVEC_UNLIKELY(!bv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "bitVec push: bv is null");
+        return -1;
+    }
+
+    if (GENVEC_UNLIKELY(bv->n_bits == SIZE_MAX)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "bitVec push: bit count would overflow");
+        return -1;
+    }
+
+    if ((bv->n_bits & 63) == 0) {
+        uint64_t zero = 0;
+        if (GENVEC_UNLIKELY(genVec_push(&bv->words, (const u8*)&zero) != 0)) { return -1; }
+    }
+    bv->n_bits++;
+    if (bit) { bitVec_set(bv, bv->n_bits - 1); }
+    return 0;
+}
+
+void bitVec_set_all(bitVec* bv)
+{
+    if (GENVEC_UNLIKELY(!bv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "bitVec set all: bv is null");
+        return;
+    }
+
+    if (bv->words.size) { memset(bv->words.data, 0xff, bv->words.size * sizeof(uint64_t)); }
+    bit_mask_tail(bv);
+}
+
+void bitVec_clear_all(bitVec* bv)
+{
+    if (GENVEC_UNLIKELY(!bv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "bitVec clear all: bv is null");
+        return;
+    }
+
+    if (bv->words.size) { memset(bv->words.data, 0, bv->words.size * sizeof(uint64_t)); }
+}
+
+int bitVec_and(bitVec* dst, const bitVec* src) {
+    return bit_binary(dst, src, BIT_AND, "bitVec and: null or size mismatch");
+}
+
+int bitVec_or(bitVec* dst, const bitVec* src) {
+    return bit_binary(dst, src, BIT_OR, "bitVec or: null or size mismatch");
+}
+
+int bitVec_xor(bitVec* dst, const bitVec* src) {
+    return bit_binary(dst, src, BIT_XOR, "bitVec xor: null or size mismatch");
+}
+
+int bitVec_andnot(bitVec* dst, const bitVec* src) {
+    return bit_binary(dst, src, BIT_ANDNOT, "bitVec andnot: null or size mismatch");
+}
+
+void bitVec_not(bitVec* bv)
+{
+    if (GENVEC_UNLIKELY(!bv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "bitVec not: bv is null");
+        return;
+    }
+
+    LOAD_FN(op_impl)(bitVec_words(bv), NULL, bv->words.size, BIT_NOT);
+    bit_mask_tail(bv);
+}
+
+size_t bitVec_count(const bitVec* bv)
+{
+    if (GENVEC_UNLIKELY(!bv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "bitVec count: bv is null");
+        return 0;
+    }
+
+    return LOAD_FN(count_impl)(bitVec_words(bv), bv->words.size);
+}
+
+size_t bitVec_find_first(const bitVec* bv) {
+    return bitVec_find_next(bv, 0);
+}
+
+size_t bitVec_find_next(const bitVec* bv, size_t from)
+{
+    if (!bv || from >= bv->n_bits) { return BITVEC_NPOS; }
+
+    const uint64_t* w = bitVec_words(bv);
+    size_t i = from >> 6;
+    uint64_t word = w[i] & (~(uint64_t)0 << (from & 63));
+
+    // whole zero words are skipped, the tail bits are 0 so nothing past n_bits is found
+    while (word == 0) {
+        if (++i == bv->words.size) { return BITVEC_NPOS; }
+        word = w[i];
+    }
+    return (i << 6) + (size_t)__builtin_ctzll(word);
+}
+
+size_t bitVec_find_next_zero(const bitVec* bv, size_t from)
+{
+    if (!bv || from >= bv->n_bits) { return BITVEC_NPOS; }
+
+    const uint64_t* w = bitVec_words(bv);
+    size_t i = from >> 6;
+    uint64_t word = ~w[i] & (~(uint64_t)0 << (from & 63));
+
+    while (word == 0) {
+        if (++i == bv->words.size) { return BITVEC_NPOS; }
+        word = ~w[i];
+    }
+
+    // the zero tail bits would show up here as unset flags
+    size_t bit = (i << 6) + (size_t)__builtin_ctzll(word);
+    return bit < bv->n_bits ? bit : BITVEC_NPOS;
+}
@@ -0,0 +1,191 @@
+#include "conc_vector.h"
+#include "genvec_diag.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Private helpers
+
+static inline size_t seg_cap(size_t seg) {
+    return CONCVEC_FIRST_SEG << seg;
+}
+
+// index -> (segment, offset): segment k starts at FIRST_SEG * (2^k - 1)
+static inline size_t seg_of(size_t i, size_t* offset)
+{
+    size_t x = i + CONCVEC_FIRST_SEG;
+    size_t top = (sizeof(unsigned long long) * 8 - 1) - (size_t)__builtin_clzll((unsigned long long)x);
+    size_t seg = top - CONCVEC_FIRST_SEG_BITS;
+
+    *offset = x - ((size_t)1 << top);
+    return seg;
+}
+
+static inline u8* seg_ready(const concVec* cv, u8* seg_data, size_t seg) {
+    return seg_data + (seg_cap(seg) * cv->data_size);
+}
+
+// segment seg, allocating it if no one has yet (racing allocators: one CAS wins)
+static u8* seg_get(concVec* cv, size_t seg)
+{
+    u8* data = __atomic_load_n(&cv->segs[seg], __ATOMIC_ACQUIRE);
+    if (data) { return data; }
+
+    // elms then one ready byte each, late segments of big elms can wrap that
+    size_t cap = seg_cap(seg);
+    if (GENVEC_UNLIKELY(cap > (SIZE_MAX - cap) / cv->data_size)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "concVec push: segment size overflows");
+        return NULL;
+    }
+    u8* fresh = calloc(cap * cv->data_size + cap, 1);   // ready bytes start out 0
+    if (GENVEC_UNLIKELY(!fresh)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "concVec push: segment alloc failed");
+        return NULL;
+    }
+
+    u8* expected = NULL;
+    if (__atomic_compare_exchange_n(&cv->segs[seg], &expected, fresh, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return fresh;
+    }
+
+    // someone else got there first, use theirs
+    free(fresh);
+    return expected;
+}
+
+
+concVec* concVec_create(size_t data_size, genVec_delete_fn del_fn)
+{
+    if (GENVEC_UNLIKELY(data_size == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "concVec create: data_size can't be 0");
+        return NULL;
+    }
+
+    concVec* cv = calloc(1, sizeof(concVec));
+    if (GENVEC_UNLIKELY(!cv)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "concVec create: malloc failed");
+        return NULL;
+    }
+
+    cv->data_size = data_size;
+    cv->del_fn = del_fn;
+
+    // first segment up front so the common case never races on allocation
+    if (!seg_get(cv, 0)) {
+        free(cv);
+        return NULL;
+    }
+
+    return cv;
+}
+
+void concVec_destroy(concVec* cv)
+{
+    if (!cv) { return; }
+
+    for (size_t seg = 0; seg < CONCVEC_MAX_SEGS; seg++) {
+        u8* data = cv->segs[seg];
+        if (!data) { continue; }
+
+        if (cv->del_fn) {
+            u8* ready = seg_ready(cv, data, seg);
+            for (size_t i = 0; i < seg_cap(seg); i++) {
+                if (ready[i]) { cv->del_fn(data + (i * cv->data_size)); }
+            }
+        }
+        free(data);
+    }
+    free(cv);
+}
+
+size_t concVec_push(concVec* cv, const u8* data)
+{
+    if (GENVEC_UNLIKELY(!cv || !data)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "concVec push: cv or data is null");
+        return CONCVEC_FULL;
+    }
+
+    // the only point of contention, one fetch-add per push
+    size_t i = __atomic_fetch_add(&cv->reserved, 1, __ATOMIC_RELAXED);
+
+    size_t offset;
+    size_t seg = seg_of(i, &offset);
+    if (GENVEC_UNLIKELY(seg >= CONCVEC_MAX_SEGS)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "concVec push: out of segments");
+        return CONCVEC_FULL;
+    }
+
+    u8* seg_data = seg_get(cv, seg);
+    if (!seg_data) { return CONCVEC_FULL; }
+
+    memcpy(seg_data + (offset * cv->data_size), data, cv->data_size);
+
+    // release: readers that see the ready byte also see the elm
+    __atomic_store_n(seg_ready(cv, seg_data, seg) + offset, 1, __ATOMIC_RELEASE);
+    return i;
+}
+
+u8* concVec_at(const concVec* cv, size_t i)
+{
+    if (!cv) { return NULL; }
+
+    size_t offset;
+    size_t seg = seg_of(i, &offset);
+    if (seg >= CONCVEC_MAX_SEGS) { return NULL; }
+
+    u8* seg_data = __atomic_load_n(&cv->segs[seg], __ATOMIC_ACQUIRE);
+    if (!seg_data) { return NULL; }
+
+    if (!__atomic_load_n(seg_ready(cv, seg_data, seg) + offset, __ATOMIC_ACQUIRE)) { return NULL; }
+    return seg_data + (offset * cv->data_size);
+}
+
+int concVec_get(const concVec* cv, size_t i, u8* out)
+{
+    if (GENVEC_UNLIKELY(!out)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "concVec get: out is null");
+        return -1;
+    }
+
+    u8* elm = concVec_at(cv, i);
+    if (!elm) { return -1; }
+
+    memcpy(out, elm, cv->data_size);
+    return 0;
+}
+
+size_t concVec_size(const concVec* cv) {
+    return cv ? __atomic_load_n(&cv->reserved, __ATOMIC_ACQUIRE) : 0;
+}
+
+genVec* concVec_to_genVec(const concVec* cv)
+{
+    if (GENVEC_UNLIKELY(!cv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "concVec to genVec: cv is null");
+        return NULL;
+    }
+
+    size_t n = concVec_size(cv);
+    genVec* vec = genVec_init(n, cv->data_size, NULL);
+    if (!vec) { return NULL; }
+
+    // whole segments at a time, skipping slots that never got published
+    for (size_t seg = 0, start = 0; start < n && seg < CONCVEC_MAX_SEGS; seg++) {
+        u8* data = cv->segs[seg];
+        size_t count = seg_cap(seg) < n - start ? seg_cap(seg) : n - start;
+        start += count;
+        if (!data) { continue; }
+
+        u8* ready = seg_ready(cv, data, seg);
+        size_t run = 0;
+        for (size_t i = 0; i <= count; i++) {
+            if (i < count && ready[i]) { run++; continue; }
+            if (run) { genVec_push_multi(vec, data + ((i - run) * cv->data_size), run); }
+            run = 0;
+        }
+    }
+
+    return vec;
+}
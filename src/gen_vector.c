@@ -1,39 +1,172 @@
 #include "gen_vector.h"
+#include "genvec_diag.h"
+#include "genvec_stats_hooks.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 
-#define GROWTH 1.5 
-#define SHRINK_AT 0.25
-#define SHRINK_BY 0.5
+const genVec_policy genVec_default_policy = {
+    .growth = 1.5,
+    .min_capacity = 4,
+    .shrink = 1,
+    .shrink_at = 0.25,
+    .shrink_by = 0.5,
+};
+
+#define POLICY(vec) ((vec)->policy ? (vec)->policy : &genVec_default_policy)
+
+// capacity * factor, saturating (casting a double past SIZE_MAX to size_t is undefined)
+static inline size_t gv_scale(size_t capacity, double factor) {
+    double v = (double)capacity * factor;
+    return v >= (double)SIZE_MAX ? SIZE_MAX : (size_t)v;
+}
+
+// most elms a block can hold before capacity * data_size wraps
+#define GV_MAX_ELMS(vec) (SIZE_MAX / (vec)->data_size)
+
+// flags about what backs the vec rather than the current buffer, they outlive dropping it
+#define GV_BACKING_FLAGS (GENVEC_MAPPED | GENVEC_FIXED)
+
+// a vec that can't grow says so instead of reporting an allocation failure
+#define GV_GROW_ERR(vec) (((vec)->flags & GENVEC_FIXED) ? GENVEC_ERR_INVALID : GENVEC_ERR_ALLOC)
+
+// a shared buffer (GENVEC_SHARED): refcount and block size sit in front of the elms,
+// two words so the elms keep malloc's alignment
+typedef struct {
+    size_t refs;
+    size_t bytes;
+} gv_shared_hdr;
+
+#define GV_SHARED_HDR(data) ((gv_shared_hdr*)(void*)(data) - 1)
 
 //private functions
 void genVec_grow(genVec* vec);
 void genVec_shrink(genVec* vec);
+static int genVec_set_capacity(genVec* vec, size_t new_cap);
+static int genVec_setup(genVec* vec, size_t n, size_t data_size, genVec_delete_fn del_fn, const genVec_allocator* alloc);
+
+
+
+// a NULL allocator means plain malloc/realloc/free
+static inline void* gv_alloc(const genVec_allocator* alloc, size_t size) {
+    return alloc ? alloc->alloc(alloc->ctx, size) : malloc(size);
+}
+
+static inline void* gv_realloc(const genVec_allocator* alloc, void* ptr, size_t old_size, size_t new_size) {
+    return alloc ? alloc->realloc(alloc->ctx, ptr, old_size, new_size) : realloc(ptr, new_size);
+}
+
+static inline void gv_free(const genVec_allocator* alloc, void* ptr, size_t size) {
+    if (alloc) { alloc->free(alloc->ctx, ptr, size); }
+    else       { free(ptr); }
+}
+
+// drop one reference, the last vec out frees the block
+static void gv_shared_release(genVec* vec)
+{
+    gv_shared_hdr* hdr = GV_SHARED_HDR(vec->data);
+    if (__atomic_fetch_sub(&hdr->refs, 1, __ATOMIC_ACQ_REL) == 1) {
+        gv_free(vec->alloc, hdr, sizeof(gv_shared_hdr) + hdr->bytes);
+    }
+}
+
+// free the buffer, or our reference to a shared one (an external buffer isn't ours)
+static void gv_free_data(genVec* vec)
+{
+    if (!vec->data) { return; }
+
+    if (vec->flags & GENVEC_SHARED)           { gv_shared_release(vec); }
+    else if (!(vec->flags & GENVEC_EXTERNAL)) { gv_free(vec->alloc, vec->data, vec->capacity * vec->data_size); }
+}
+
+// copy on write: a shared buffer gets a private copy before anything writes to it
+static inline int gv_own(genVec* vec) {
+    return GENVEC_UNLIKELY(vec->flags & GENVEC_SHARED) ? genVec_unshare(vec) : 0;
+}
+
+// room for n more elms, checking that size + n doesn't wrap first
+static inline int gv_ensure_more(genVec* vec, size_t n) {
+    if (GENVEC_UNLIKELY(n > SIZE_MAX - vec->size)) {
+        GENVEC_FAIL_QUIET(GENVEC_ERR_ALLOC);
+        return -1;
+    }
+    return genVec_ensure(vec, vec->size + n);
+}
 
 
 genVec* genVec_init(size_t n, size_t data_size, genVec_delete_fn del_fn) {
-    if (data_size == 0) { 
-        printf("init: data_size can't be 0\n");
+    return genVec_init_alloc(n, data_size, del_fn, NULL);
+}
+
+genVec* genVec_init_alloc(size_t n, size_t data_size, genVec_delete_fn del_fn, const genVec_allocator* alloc)
+{
+    if (GENVEC_UNLIKELY(data_size == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "init: data_size can't be 0");
         return NULL; 
     }
 
-    genVec* vec = malloc(sizeof(genVec));
-    if (!vec) { 
-        printf("init: vec init failed\n");
+    genVec* vec = gv_alloc(alloc, sizeof(genVec));
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "init: vec init failed");
         return NULL; 
     }
 
+    if (genVec_setup(vec, n, data_size, del_fn, alloc) != 0) {
+        gv_free(alloc, vec, sizeof(genVec));
+        return NULL;
+    }
+
+    return vec;
+}
+
+int genVec_init_inplace(genVec* vec, size_t n, size_t data_size, genVec_delete_fn del_fn)
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "init inplace: vec is null");
+        return -1;
+    }
+
+    return genVec_setup(vec, n, data_size, del_fn, NULL);
+}
+
+int genVec_set_allocator(genVec* vec, const genVec_allocator* alloc)
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "set allocator: vec is null");
+        return -1;
+    }
+    // data we already own would be freed with the wrong allocator
+    if (GENVEC_UNLIKELY(vec->data && !(vec->flags & GENVEC_EXTERNAL))) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "set allocator: vec already owns data");
+        return -1;
+    }
+
+    vec->alloc = alloc;
+    return 0;
+}
+
+static int genVec_setup(genVec* vec, size_t n, size_t data_size, genVec_delete_fn del_fn, const genVec_allocator* alloc)
+{
+    if (GENVEC_UNLIKELY(data_size == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "init inplace: data_size can't be 0");
+        return -1; 
+    }
+
+    if (GENVEC_UNLIKELY(n > SIZE_MAX / data_size)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "vec init: n * data_size overflows");
+        return -1;
+    }
+
     // Only allocate memory if n > 0, otherwise data can be NULL
-    vec->data = (n > 0) ? malloc(data_size * n) : NULL;
+    vec->data = (n > 0) ? gv_alloc(alloc, data_size * n) : NULL;
     
     // Only check for allocation failure if we actually tried to allocate
-    if (n > 0 && !vec->data) {
-        free(vec);
-        printf("vec init: data init failed\n");
-        return NULL;
+    if (GENVEC_UNLIKELY(n > 0 && !vec->data)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "vec init: data init failed");
+        return -1;
     }
     
     vec->size = 0;
@@ -41,22 +174,46 @@ genVec* genVec_init(size_t n, size_t data_size, genVec_delete_fn del_fn) {
     vec->data_size = data_size;
 
     vec->del_fn = del_fn; // NULL if no del_fn
+    vec->alloc = alloc;
+    vec->policy = NULL;
+    vec->flags = 0;
+#ifdef GENVEC_STATS
+    memset(&vec->stats, 0, sizeof(vec->stats));
+#endif
 
-    return vec;
+    return 0;
+}
+
+int genVec_init_buffer(genVec* vec, u8* buf, size_t buf_cap, size_t data_size, genVec_delete_fn del_fn)
+{
+    if (GENVEC_UNLIKELY(!buf || buf_cap == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "init buffer: buf is null or empty");
+        return -1;
+    }
+    if (genVec_init_inplace(vec, 0, data_size, del_fn) != 0) {
+        return -1;
+    }
+
+    // buf stays owned by the caller, we only copy out of it when it overflows
+    vec->data = buf;
+    vec->capacity = buf_cap;
+    vec->flags = GENVEC_EXTERNAL;
+
+    return 0;
 }
 
 genVec* genVec_init_val(size_t n, const u8* val, size_t data_size, genVec_delete_fn del_fn) 
 {
-    if (val == NULL) {
-        printf("val can't be null\n");
+    if (GENVEC_UNLIKELY(val == NULL)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "val can't be null");
         return NULL;
     }
 
     genVec* vec = genVec_init(n, data_size, del_fn);
     if (!vec) { return NULL; }
 
-    if (n == 0) {
-        printf("cant init with val if n = 0\n");
+    if (GENVEC_UNLIKELY(n == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "cant init with val if n = 0");
         return vec;
     }
 
@@ -70,11 +227,23 @@ genVec* genVec_init_val(size_t n, const u8* val, size_t data_size, genVec_delete
 }
 
 void genVec_destroy(genVec* vec) {
-    if (!vec) {
-        printf("del: vector is null\n");
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "del: vector is null");
         return;
     }
     
+    const genVec_allocator* alloc = vec->alloc;
+
+    genVec_deinit(vec);
+    gv_free(alloc, vec, sizeof(genVec));
+}
+
+void genVec_deinit(genVec* vec) {
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "deinit: vector is null");
+        return;
+    }
+
     if (vec->del_fn) {
         // Custom cleanup for each element
         for (size_t i = 0; i < vec->size; i++) {
@@ -83,16 +252,17 @@ void genVec_destroy(genVec* vec) {
         }
     }
     
-    if (vec->data) {
-        free(vec->data);
-        vec->data = NULL;
-    }
-    free(vec);
+    gv_free_data(vec);
+
+    vec->data = NULL;
+    vec->size = 0;
+    vec->capacity = 0;
+    vec->flags &= GV_BACKING_FLAGS;    // the buffer goes, the file behind it stays
 }
 
 void genVec_clear(genVec* vec) {
-    if (!vec) {
-        printf("clear: vector is null\n");
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "clear: vector is null");
         return;
     }
 
@@ -103,67 +273,109 @@ void genVec_clear(genVec* vec) {
         }
     }
 
-    if (vec->data) {
-        free(vec->data);
-        vec->data = NULL;
-    }
-
     vec->size = 0;
+
+    // keep using the caller's buffer, it costs nothing to hold on to
+    if (vec->flags & GENVEC_EXTERNAL) { return; }
+
+    gv_free_data(vec);
+    vec->data = NULL;
     vec->capacity = 0;
+    vec->flags &= GV_BACKING_FLAGS;
 }
 
-void genVec_reserve(genVec* vec, size_t new_capacity) 
+int genVec_reserve(genVec* vec, size_t new_capacity) 
 {
-    if (!vec) {
-        printf("reserve: vec is null\n");
-        return;
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "reserve: vec is null");
+        return -1;
     }
     
     // Only grow, never shrink with reserve
     if (new_capacity <= vec->capacity) {
-        return;
+        return 0;
     }
     
-    u8* new_data = realloc(vec->data, new_capacity * vec->data_size);
-    if (!new_data) {
-        printf("reserve: realloc failed\n");
-        return;
+    if (GENVEC_UNLIKELY(genVec_set_capacity(vec, new_capacity) != 0)) {
+        GENVEC_FAIL(GV_GROW_ERR(vec), "reserve: realloc failed");
+        return -1;
     }
-    
-    vec->data = new_data;
-    vec->capacity = new_capacity;
+
+    return 0;
 }
 
-void genVec_push(genVec* vec, const u8* data) 
+void genVec_shrink_to_fit(genVec* vec)
 {
-    if (!vec) {
-        printf("push: vec is null\n");
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "shrink to fit: vec is null");
         return;
     }
+    if (vec->size == vec->capacity || (vec->flags & GENVEC_EXTERNAL)) { return; }
 
-    // Check if we need to allocate or grow
-    if (vec->size >= vec->capacity || !vec->data) 
-        { genVec_grow(vec); }
-
-    // If data is still NULL after grow, we have a problem
-    if (!vec->data) {
-        printf("push: data allocation failed\n");
+    if (vec->size == 0) {
+        gv_free_data(vec);
+        vec->data = NULL;
+        vec->capacity = 0;
+        vec->flags &= GV_BACKING_FLAGS;
         return;
     }
 
+    if (GENVEC_UNLIKELY(genVec_set_capacity(vec, vec->size) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "shrink to fit: realloc failed");
+    }
+}
+
+int genVec_set_policy(genVec* vec, const genVec_policy* policy)
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "set policy: vec is null");
+        return -1;
+    }
+    // written as !(x > y) so NaN fails too
+    if (GENVEC_UNLIKELY(policy && (!(policy->growth > 1.0) || !isfinite(policy->growth) ||
+                   !(policy->shrink_by > 0.0) || !(policy->shrink_by <= 1.0) ||
+                   (policy->shrink && !(policy->shrink_at >= 0.0 && policy->shrink_at < policy->shrink_by)))))
+    {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "set policy: need finite growth > 1 and 0 <= shrink_at < shrink_by <= 1");
+        return -1;
+    }
+
+    vec->policy = policy;
+    return 0;
+}
+
+int genVec_push(genVec* vec, const u8* data) 
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "push: vec is null");
+        return -1;
+    }
+
+    // Check if we need to allocate or grow (or copy a shared buffer)
+    if (vec->size >= vec->capacity || !vec->data || (vec->flags & GENVEC_SHARED)) 
+        { genVec_ensure(vec, vec->size + 1); }
+
+    // If there is still no room after grow, we have a problem
+    if (GENVEC_UNLIKELY(vec->size >= vec->capacity || (vec->flags & GENVEC_SHARED))) {
+        GENVEC_FAIL(GV_GROW_ERR(vec), "push: data allocation failed");
+        return -1;
+    }
+
     u8* next_to_last = vec->data + (vec->size * vec->data_size); 
     memcpy(next_to_last, data, vec->data_size);
 
     vec->size++;
+
+    return 0;
 }
 
 int genVec_pop(genVec* vec, u8* popped) {
-    if (!vec) {
-        printf("pop: vec is null\n");
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "pop: vec is null");
         return -1;
     }
-    if (vec->size == 0) {
-        printf("pop: vec is empty\n");
+    if (GENVEC_UNLIKELY(vec->size == 0)) {
+        GENVEC_FAIL_QUIET(GENVEC_ERR_EMPTY);
         return -1;
     }
     
@@ -177,48 +389,53 @@ int genVec_pop(genVec* vec, u8* popped) {
 
     vec->size--;    // set for re-write
 
-    if (vec->size <= (size_t)((double)vec->capacity * SHRINK_AT)) 
-        { genVec_shrink(vec); }
+    genVec_auto_shrink(vec);
 
     return 0;
 }
 
-void genVec_get(const genVec* vec, size_t i, u8* out) {
-    if (!vec) {
-        printf("get: vec is null\n");
-        return;
+int genVec_get(const genVec* vec, size_t i, u8* out) {
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "get: vec is null");
+        return -1;
     }
-    if (i >= vec->size) {
-        printf("get: index of of bounds\n");
-        return;
+    if (GENVEC_UNLIKELY(i >= vec->size)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "get: index of of bounds");
+        return -1;
     }
-    if (!out) {
-        printf("get: need a valid out variable to get the element\n");
-        return;
+    if (GENVEC_UNLIKELY(!out)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "get: need a valid out variable to get the element");
+        return -1;
     }
 
     u8* elm = vec->data + (i * vec->data_size);
     memcpy(out, elm, vec->data_size);
+
+    return 0;
 }
 
-void genVec_insert(genVec* vec, size_t i, const u8* data)
+int genVec_insert(genVec* vec, size_t i, const u8* data)
 {
-    if (!vec || !data) {
-        printf("insert: vec or data or vec-data is null\n");
-        return;
+    if (GENVEC_UNLIKELY(!vec || !data)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "insert: vec or data or vec-data is null");
+        return -1;
     }
-    if (i > vec->size) {
-        printf("insert: index out of bounds\n");
-        return;
+    if (GENVEC_UNLIKELY(i > vec->size)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "insert: index out of bounds");
+        return -1;
     }
     if (i == vec->size) {
-        genVec_push(vec, data);
-        return;
+        return genVec_push(vec, data);
     }
 
-    // Check if we need to allocate or grow
-    if (vec->size >= vec->capacity || !vec->data) 
-        { genVec_grow(vec); }
+    // Check if we need to allocate or grow (or copy a shared buffer)
+    if (vec->size >= vec->capacity || !vec->data || (vec->flags & GENVEC_SHARED)) 
+        { genVec_ensure(vec, vec->size + 1); }
+
+    if (GENVEC_UNLIKELY(vec->size >= vec->capacity || (vec->flags & GENVEC_SHARED))) {
+        GENVEC_FAIL(GV_GROW_ERR(vec), "insert: data allocation failed");
+        return -1;
+    }
 
     // Calculate the number of elements to shift to right
     size_t elements_to_shift = vec->size - i;
@@ -228,38 +445,40 @@ void genVec_insert(genVec* vec, size_t i, const u8* data)
     // Shift elements right by one unit
     u8* dest = vec->data + ((i + 1) * vec->data_size);
     memmove(dest, src, elements_to_shift * vec->data_size);  // Use memmove for overlapping regions
+    GENVEC_STAT_MOVE(vec, elements_to_shift * vec->data_size);
 
     //src pos is now free to insert (it's data copied to next location)
     memcpy(src, data, vec->data_size);
 
     vec->size++;  
+
+    return 0;
 }
 
 
-void genVec_insert_multi(genVec* vec, size_t i, const u8* data, size_t num_data)
+int genVec_insert_multi(genVec* vec, size_t i, const u8* data, size_t num_data)
 {
-    if (!vec || !data || num_data == 0) 
+    if (GENVEC_UNLIKELY(!vec || !data || num_data == 0)) 
     {
-        printf("insertM: vec or data or vec-data is null\n");
-        return;
+        GENVEC_FAIL(GENVEC_ERR_NULL, "insertM: vec or data or vec-data is null");
+        return -1;
     }
-    if (i > vec->size) {
-        printf("insertM: index out of bounds\n");
-        return;
+    if (GENVEC_UNLIKELY(i > vec->size)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "insertM: index out of bounds");
+        return -1;
     }
 
     // Calculate the number of elements to shift to right
     size_t elements_to_shift = vec->size - i;
 
-    vec->size += num_data;
-
-    genVec_reserve(vec, vec->size);
-    if (!vec->data) {
-        printf("insertM: genvec reserve failed\n");
-        vec->size -= num_data;
-        return;
+    // geometric growth, so repeated bulk inserts don't realloc every time
+    if (GENVEC_UNLIKELY(gv_ensure_more(vec, num_data) != 0)) {
+        GENVEC_FAIL(GV_GROW_ERR(vec), "insertM: genvec reserve failed");
+        return -1;
     }
 
+    vec->size += num_data;
+
     // the place where we want to insert
     u8* src = vec->data + (i * vec->data_size);
     if (elements_to_shift > 0) {
@@ -267,22 +486,145 @@ void genVec_insert_multi(genVec* vec, size_t i, const u8* data, size_t num_data)
         u8* dest = vec->data + ((i + num_data) * vec->data_size);
 
         memmove(dest, src, elements_to_shift * vec->data_size);  // using memmove for overlapping regions
+        GENVEC_STAT_MOVE(vec, elements_to_shift * vec->data_size);
     }
 
     //src pos is now free to insert (it's data copied to next location)
     memcpy(src, data, num_data * vec->data_size);
+
+    return 0;
 }
 
-void genVec_remove(genVec* vec, size_t i) {
-    if (!vec) {
-        printf("remove: vec is null\n");
-        return;
+int genVec_push_multi(genVec* vec, const u8* data, size_t num_data)
+{
+    if (GENVEC_UNLIKELY(!vec || (!data && num_data > 0))) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "pushM: vec or data is null");
+        return -1;
     }
-    if (i >= vec->size) {
-        printf("remove: index out of bounds\n");
-        return;
+    if (num_data == 0) { return 0; }
+
+    if (GENVEC_UNLIKELY(gv_ensure_more(vec, num_data) != 0)) {
+        GENVEC_FAIL(GV_GROW_ERR(vec), "pushM: data allocation failed");
+        return -1;
+    }
+
+    memcpy(vec->data + (vec->size * vec->data_size), data, num_data * vec->data_size);
+    vec->size += num_data;
+
+    return 0;
+}
+
+// elements are copied bytewise, same as genVec_copy
+int genVec_extend(genVec* dst, const genVec* src)
+{
+    if (GENVEC_UNLIKELY(!dst || !src)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "extend: dst or src is null");
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(dst->data_size != src->data_size)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "extend: data_size mismatch");
+        return -1;
+    }
+
+    size_t num_data = src->size;
+    if (num_data == 0) { return 0; }
+
+    // src can be dst, so only read src->data after growing
+    if (GENVEC_UNLIKELY(gv_ensure_more(dst, num_data) != 0)) {
+        GENVEC_FAIL(GV_GROW_ERR(dst), "extend: data allocation failed");
+        return -1;
     }
 
+    memcpy(dst->data + (dst->size * dst->data_size), src->data, num_data * dst->data_size);
+    dst->size += num_data;
+
+    return 0;
+}
+
+int genVec_resize(genVec* vec, size_t n, const u8* fill)
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "resize: vec is null");
+        return -1;
+    }
+
+    if (n <= vec->size) {
+        if (vec->del_fn) {
+            for (size_t i = n; i < vec->size; i++) {
+                vec->del_fn(vec->data + (i * vec->data_size));
+            }
+        }
+        vec->size = n;
+        return 0;
+    }
+
+    if (GENVEC_UNLIKELY(genVec_ensure(vec, n) != 0)) {
+        GENVEC_FAIL(GV_GROW_ERR(vec), "resize: data allocation failed");
+        return -1;
+    }
+
+    // new elements are copies of fill, or zeroed without one
+    u8* elm = vec->data + (vec->size * vec->data_size);
+    if (fill) {
+        for (size_t i = vec->size; i < n; i++) {
+            memcpy(elm, fill, vec->data_size);
+            elm += vec->data_size;
+        }
+    } else {
+        memset(elm, 0, (n - vec->size) * vec->data_size);
+    }
+
+    vec->size = n;
+
+    return 0;
+}
+
+int genVec_remove_range(genVec* vec, size_t i, size_t n)
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "remove range: vec is null");
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(i > vec->size || n > vec->size - i)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "remove range: range out of bounds");
+        return -1;
+    }
+    if (n == 0) { return 0; }
+    if (gv_own(vec) != 0) { return -1; }
+
+    u8* dest = vec->data + (i * vec->data_size);
+
+    if (vec->del_fn) {
+        for (size_t j = 0; j < n; j++) {
+            vec->del_fn(dest + (j * vec->data_size));
+        }
+    }
+
+    // one shift for the whole range
+    size_t elements_to_shift = vec->size - i - n;
+    if (elements_to_shift > 0) {
+        memmove(dest, dest + (n * vec->data_size), elements_to_shift * vec->data_size);
+        GENVEC_STAT_MOVE(vec, elements_to_shift * vec->data_size);
+    }
+
+    vec->size -= n;
+
+    genVec_auto_shrink(vec);
+
+    return 0;
+}
+
+int genVec_remove(genVec* vec, size_t i) {
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "remove: vec is null");
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(i >= vec->size)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "remove: index out of bounds");
+        return -1;
+    }
+    if (gv_own(vec) != 0) { return -1; }
+
     if (vec->del_fn) {
         u8* element = vec->data + (i * vec->data_size);
         vec->del_fn(element);
@@ -296,29 +638,32 @@ void genVec_remove(genVec* vec, size_t i) {
         u8* src = vec->data + ((i + 1) * vec->data_size);
         
         memmove(dest, src, elements_to_shift * vec->data_size);  // Use memmove for overlapping regions
+        GENVEC_STAT_MOVE(vec, elements_to_shift * vec->data_size);
     }
 
     vec->size--;
     
-    if (vec->size <= (size_t)((double)vec->capacity * SHRINK_AT)) 
-        { genVec_shrink(vec); }
+    genVec_auto_shrink(vec);
+
+    return 0;
 }
 
 
 
-void genVec_replace(genVec* vec, size_t i, const u8* data) {
-    if (!vec) {
-        printf("replace: vec is null\n");
-        return;
+int genVec_replace(genVec* vec, size_t i, const u8* data) {
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "replace: vec is null");
+        return -1;
     } 
-    if (i >= vec->size) {
-        printf("replace: index of of bounds\n");
-        return;
+    if (GENVEC_UNLIKELY(i >= vec->size)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "replace: index of of bounds");
+        return -1;
     }
-    if (!data) {
-        printf("replace: need a valid data variable\n");
-        return;
+    if (GENVEC_UNLIKELY(!data)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "replace: need a valid data variable");
+        return -1;
     }   
+    if (gv_own(vec) != 0) { return -1; }
 
     u8* to_replace = vec->data + (i * vec->data_size); 
 
@@ -327,56 +672,74 @@ void genVec_replace(genVec* vec, size_t i, const u8* data) {
     }
 
     memcpy(to_replace, data, vec->data_size);
+
+    return 0;
 }
 
-void genVec_front(const genVec* vec, u8* out) {
-    if (!vec) {
-        printf("front: vec is null\n");
-        return;
+int genVec_front(const genVec* vec, u8* out) {
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "front: vec is null");
+        return -1;
     }
-    if (vec->size == 0) {
-        printf("front: vec is empty\n");
-        return;
+    if (GENVEC_UNLIKELY(vec->size == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_EMPTY, "front: vec is empty");
+        return -1;
     }
     
     memcpy(out, vec->data, vec->data_size);
+
+    return 0;
 }
 
 
-void genVec_back(const genVec* vec, u8* out) {
-    if (!vec) {
-        printf("back: vec is null\n");
-        return;
+int genVec_back(const genVec* vec, u8* out) {
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "back: vec is null");
+        return -1;
     }
-    if (vec->size == 0) {
-        printf("back: vec is empty\n");
-        return;
+    if (GENVEC_UNLIKELY(vec->size == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_EMPTY, "back: vec is empty");
+        return -1;
     }
     
     u8* last_elm = vec->data + ((vec->size - 1) * vec->data_size);
     memcpy(out, last_elm, vec->data_size);
+
+    return 0;
 }
 
 
 
 // this is a shallow copy if elements are pointers
 genVec* genVec_copy(genVec* src) {
-    if (!src) {
-        printf("copy: src is null\n");
+    if (GENVEC_UNLIKELY(!src)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "copy: src is null");
         return NULL;
     }
+    // src's allocator only resizes its file, copies go into a heap vec with genVec_assign
+    if (GENVEC_UNLIKELY(src->flags & GENVEC_MAPPED)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "copy: src is a mapped vec");
+        return NULL;
+    }
+
+    // a shared buffer just gets one more reference
+    size_t n = (src->flags & GENVEC_SHARED) ? 0 : src->size;
 
-    genVec* vec = genVec_init(src->size, src->data_size, src->del_fn);
-    if (!vec) {
-        printf("copy: genVec init failed\n");
+    genVec* vec = genVec_init_alloc(n, src->data_size, src->del_fn, src->alloc);
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "copy: genVec init failed");
         return NULL;
     }
+    if (src->flags & GENVEC_SHARED) {
+        genVec_assign(vec, src);
+        return vec;
+    }
     if (src->size == 0) {
         return vec;
     }
-    if (!src->data || !vec->data) {
+    if (GENVEC_UNLIKELY(!src->data || !vec->data)) {
         genVec_destroy(vec);
-        printf("copy: ivalid data pointers\n");
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "copy: ivalid data pointers");
         return NULL;
     }
 
@@ -386,13 +749,196 @@ genVec* genVec_copy(genVec* src) {
     return vec;
 }
 
+int genVec_assign(genVec* dst, const genVec* src)
+{
+    if (GENVEC_UNLIKELY(!dst || !src)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "assign: dst or src is null");
+        return -1;
+    }
+    if (dst == src) { return 0; }
+
+    // the last vec out frees the block with its allocator, so those have to match
+    if ((src->flags & GENVEC_SHARED) && src->alloc == dst->alloc) {
+        genVec_deinit(dst);
+        __atomic_fetch_add(&GV_SHARED_HDR(src->data)->refs, 1, __ATOMIC_RELAXED);
+
+        dst->data = src->data;
+        dst->size = src->size;
+        dst->capacity = src->capacity;
+        dst->data_size = src->data_size;
+        dst->del_fn = NULL;
+        dst->flags = GENVEC_SHARED;
+        return 0;
+    }
+
+    if (dst->data_size != src->data_size) {
+        genVec_deinit(dst);
+        dst->data_size = src->data_size;
+    } else {
+        genVec_resize(dst, 0, NULL);
+    }
+    dst->del_fn = src->del_fn;
+
+    return genVec_push_multi(dst, src->data, src->size);
+}
+
+int genVec_share(genVec* vec)
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "share: vec is null");
+        return -1;
+    }
+    if (vec->flags & GENVEC_SHARED) { return 0; }
+    // the refcounted block would have to come from the file
+    if (GENVEC_UNLIKELY(vec->flags & GENVEC_MAPPED)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "share: a mapped vec can't be shared");
+        return -1;
+    }
+    // every copy would run del_fn on the same elms
+    if (GENVEC_UNLIKELY(vec->del_fn)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "share: elms with a del_fn can't be shared");
+        return -1;
+    }
+    if (vec->size == 0) { return 0; }   // nothing to share, empty copies cost nothing
+
+    // one copy into a block sized to fit, with the refcount in front
+    size_t bytes = vec->size * vec->data_size;
+    gv_shared_hdr* hdr = gv_alloc(vec->alloc, sizeof(gv_shared_hdr) + bytes);
+    if (GENVEC_UNLIKELY(!hdr)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "share: block allocation failed");
+        return -1;
+    }
+
+    hdr->refs = 1;
+    hdr->bytes = bytes;
+    memcpy(hdr + 1, vec->data, bytes);
+
+    gv_free_data(vec);
+    vec->data = (u8*)(hdr + 1);
+    vec->capacity = vec->size;
+    vec->flags = GENVEC_SHARED;
+    return 0;
+}
+
+int genVec_unshare(genVec* vec)
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "unshare: vec is null");
+        return -1;
+    }
+    if (!(vec->flags & GENVEC_SHARED)) { return 0; }
+
+    if (GENVEC_UNLIKELY(genVec_set_capacity(vec, vec->capacity) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "unshare: copy failed");
+        return -1;
+    }
+    return 0;
+}
+
+void genVec_swap(genVec* a, genVec* b)
+{
+    if (GENVEC_UNLIKELY(!a || !b)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "swap: vec is null");
+        return;
+    }
+    // each header goes back to its own allocator on destroy, so the buffers must match it
+    if (GENVEC_UNLIKELY(a->alloc != b->alloc)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "swap: vecs use different allocators");
+        return;
+    }
+
+    // contents move, the allocator and policy stay with the vec
+    genVec tmp = *a;
+
+    a->data = b->data;
+    a->size = b->size;
+    a->capacity = b->capacity;
+    a->data_size = b->data_size;
+    a->del_fn = b->del_fn;
+    a->flags = b->flags;
+
+    b->data = tmp.data;
+    b->size = tmp.size;
+    b->capacity = tmp.capacity;
+    b->data_size = tmp.data_size;
+    b->del_fn = tmp.del_fn;
+    b->flags = tmp.flags;
+}
+
+int genVec_take(genVec* dst, genVec* src)
+{
+    if (GENVEC_UNLIKELY(!dst || !src)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "take: vec is null");
+        return -1;
+    }
+    if (dst == src) { return 0; }
+    if (GENVEC_UNLIKELY(dst->alloc != src->alloc)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "take: vecs use different allocators");
+        return -1;
+    }
+
+    // dst's old elms are deleted, then it gets src's buffer without copying
+    genVec_deinit(dst);
+
+    dst->data = src->data;
+    dst->size = src->size;
+    dst->capacity = src->capacity;
+    dst->data_size = src->data_size;
+    dst->del_fn = src->del_fn;
+    dst->flags = src->flags;
+
+    // src keeps its own elm type, so it can be pushed to again
+    src->data = NULL;
+    src->size = 0;
+    src->capacity = 0;
+    src->flags = 0;
+    return 0;
+}
+
+u8* genVec_release(genVec* vec, size_t* size, size_t* capacity)
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "release: vec is null");
+        return NULL;
+    }
+    if (gv_own(vec) != 0) { return NULL; }
+
+    u8* data = vec->data;
+    if (size) { *size = vec->size; }
+    if (capacity) { *capacity = vec->capacity; }
+
+    // the caller owns the buffer and its elms now, nothing gets deleted
+    vec->data = NULL;
+    vec->size = 0;
+    vec->capacity = 0;
+    vec->flags &= GV_BACKING_FLAGS;
+
+    return data;
+}
+
+genVec* genVec_adopt(u8* data, size_t size, size_t capacity, size_t data_size, genVec_delete_fn del_fn)
+{
+    if (GENVEC_UNLIKELY((!data && capacity > 0) || size > capacity)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "adopt: invalid buffer");
+        return NULL;
+    }
+
+    genVec* vec = genVec_init(0, data_size, del_fn);
+    if (!vec) { return NULL; }
+
+    vec->data = data;
+    vec->size = size;
+    vec->capacity = capacity;
+    return vec;
+}
+
 void genVec_print(const genVec* vec, genVec_print_fn fn) { 
-    if (!vec) {
-        printf("print: vec is null\n");
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "print: vec is null");
         return;
     }
-    if (!fn) {
-        printf("print: print func is null\n");
+    if (GENVEC_UNLIKELY(!fn)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "print: print func is null");
         return; 
     }
 
@@ -409,45 +955,111 @@ void genVec_print(const genVec* vec, genVec_print_fn fn) {
 }
 
 void genVec_grow(genVec* vec) {
-    if (!vec) {
-        printf("grow: vec is null\n");
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "grow: vec is null");
         return;
     }
 
-    size_t new_cap;
-    if (vec->capacity < 4) { new_cap = vec->capacity + 1; }
-    else {
-        new_cap = (size_t)((double)vec->capacity * GROWTH); 
+    if (GENVEC_UNLIKELY(genVec_ensure(vec, vec->capacity + 1) != 0)) {
+        GENVEC_FAIL(GV_GROW_ERR(vec), "grow: realloc failed");
+        return;
     }
+}
 
-    u8* new_data = realloc(vec->data, new_cap * vec->data_size);
-    if (!new_data) { 
-        printf("grow: realloc failed\n");
-        return;
+// shrinking kicks in only below shrink_at, and only down to shrink_by,
+// so a vec bouncing around one size doesn't realloc back and forth
+void genVec_auto_shrink(genVec* vec) {
+    if (!vec) { return; }
+
+    const genVec_policy* p = POLICY(vec);
+    if (p->shrink && vec->size <= gv_scale(vec->capacity, p->shrink_at)) 
+        { genVec_shrink(vec); }
+}
+
+// make room for at least needed elements, growing geometrically per the policy
+int genVec_ensure(genVec* vec, size_t needed)
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "ensure: vec is null");
+        return -1;
+    }
+    if (needed <= vec->capacity) { return gv_own(vec); }
+    if (GENVEC_UNLIKELY(needed > GV_MAX_ELMS(vec))) {
+        GENVEC_FAIL_QUIET(GENVEC_ERR_ALLOC);   // callers print their own message
+        return -1;
     }
 
-    vec->data = new_data;
-    vec->capacity = new_cap;
+    const genVec_policy* p = POLICY(vec);
+
+    // jump straight to min_capacity instead of crawling up one at a time
+    size_t new_cap = gv_scale(vec->capacity, p->growth);
+    if (new_cap <= vec->capacity) { new_cap = vec->capacity + 1; }
+    if (new_cap < p->min_capacity) { new_cap = p->min_capacity; }
+    if (new_cap < needed) { new_cap = needed; }
+    if (new_cap > GV_MAX_ELMS(vec)) { new_cap = GV_MAX_ELMS(vec); }
+
+    return genVec_set_capacity(vec, new_cap);
 }
 
 
 void genVec_shrink(genVec* vec) {
-    if (!vec) {
-        printf("shrink: vec is null\n ");
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "shrink: vec is null");
         return;
     }
 
-    size_t reduced_cap = (size_t)((double)vec->capacity * SHRINK_BY);
-    if (reduced_cap < vec->size || reduced_cap == 0) { return; }
+    // no point in moving off a caller's buffer to use less of it
+    if (vec->flags & GENVEC_EXTERNAL) { return; }
 
-    u8* new_data = realloc(vec->data, reduced_cap * vec->data_size);
-    if (!new_data) {
-        printf("shrink: realloc failed\n");
+    const genVec_policy* p = POLICY(vec);
+
+    size_t reduced_cap = gv_scale(vec->capacity, p->shrink_by);
+    if (reduced_cap < p->min_capacity) { reduced_cap = p->min_capacity; }
+    if (reduced_cap < vec->size || reduced_cap == 0 || reduced_cap >= vec->capacity) { return; }
+
+    if (GENVEC_UNLIKELY(genVec_set_capacity(vec, reduced_cap) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "shrink: realloc failed");
         return;
     }
+}
+
+// resize the data block to new_cap elements, moving off an external or shared buffer if needed
+static int genVec_set_capacity(genVec* vec, size_t new_cap)
+{
+    u8* new_data;
+
+    // a fixed vec never gets to ask its allocator
+    if (GENVEC_UNLIKELY(vec->flags & GENVEC_FIXED)) {
+        GENVEC_FAIL_QUIET(GENVEC_ERR_INVALID);   // callers print their own message
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(new_cap > GV_MAX_ELMS(vec))) {
+        GENVEC_FAIL_QUIET(GENVEC_ERR_ALLOC);
+        return -1;
+    }
+
+    if (vec->flags & (GENVEC_EXTERNAL | GENVEC_SHARED)) {
+        new_data = gv_alloc(vec->alloc, new_cap * vec->data_size);
+        if (new_data && vec->size > 0) {
+            memcpy(new_data, vec->data, vec->size * vec->data_size);
+        }
+    } else {
+        new_data = gv_realloc(vec->alloc, vec->data, vec->capacity * vec->data_size,
+                              new_cap * vec->data_size);
+    }
 
+    if (GENVEC_UNLIKELY(!new_data)) {
+        GENVEC_FAIL_QUIET(GENVEC_ERR_ALLOC);   // callers print their own message
+        return -1;
+    }
+
+    GENVEC_STAT_RESIZE(vec, vec->capacity, new_cap);
+    if (vec->flags & GENVEC_SHARED) { gv_shared_release(vec); }
     vec->data = new_data;
-    vec->capacity = reduced_cap;
+    vec->capacity = new_cap;
+    vec->flags &= ~(GENVEC_EXTERNAL | GENVEC_SHARED);
+
+    return 0;
 }
 
 
@@ -0,0 +1,320 @@
+#include "gen_vector.h"
+#include "thread_pool.h"
+#include "genvec_diag.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define ALGO_LINE 64
+// chunks are at least this big, so a chunk is worth a trip through the pool
+#define ALGO_CHUNK_MIN_BYTES (64 * 1024)
+#define ALGO_MAX_CHUNKS 1024
+
+
+// Private helpers
+
+// chunk k covers [start(k), end(k)). Boundaries sit on the first elm that starts a
+// cache line and every chunk elms after it, so neighbouring chunks never share a line
+// (when the element size allows it at all).
+typedef struct {
+    size_t n;
+    size_t skew;        // where the aligned boundaries start
+    size_t chunk;       // elms per chunk, a whole number of cache lines
+    size_t n_chunks;
+} algo_chunks;
+
+static size_t algo_gcd(size_t a, size_t b) {
+    while (b) { size_t t = a % b; a = b; b = t; }
+    return a;
+}
+
+static void algo_chunks_init(algo_chunks* c, const u8* base, size_t n, size_t sz)
+{
+    // fewest elms that span a whole number of cache lines
+    size_t line_elems = ALGO_LINE / algo_gcd(sz, ALGO_LINE);
+
+    c->n = n;
+    c->skew = 0;
+    for (size_t i = 0; i < line_elems && i < n; i++) {
+        if (((uintptr_t)(base + (i * sz)) % ALGO_LINE) == 0) { c->skew = i; break; }
+    }
+
+    size_t chunk = ALGO_CHUNK_MIN_BYTES / sz;
+    if (chunk < n / ALGO_MAX_CHUNKS) { chunk = n / ALGO_MAX_CHUNKS; }
+    chunk = ((chunk + line_elems - 1) / line_elems) * line_elems;
+    if (chunk == 0) { chunk = line_elems; }
+    c->chunk = chunk;
+
+    c->n_chunks = n > c->skew ? (n - c->skew + chunk - 1) / chunk : 1;
+}
+
+static inline size_t algo_start(const algo_chunks* c, size_t k) {
+    return k == 0 ? 0 : c->skew + (k * c->chunk);
+}
+
+static inline size_t algo_end(const algo_chunks* c, size_t k) {
+    size_t end = c->skew + ((k + 1) * c->chunk);
+    return end < c->n ? end : c->n;
+}
+
+typedef struct {
+    algo_chunks chunks;
+    u8* data;                   // vec (or src) elms
+    u8* out;                    // dst elms for map
+    size_t sz;
+    size_t out_sz;
+    genVec_delete_fn del_fn;
+    genVec_visit_fn visit;
+    genVec_map_fn map;
+    genVec_pred_fn keep;
+    genVec_reduce_fn reduce;
+    void* ctx;
+    size_t* kept;               // filter: elms kept per chunk
+    u8* accs;                   // reduce: one acc per chunk
+    size_t acc_size;
+} algo_job;
+
+static void algo_visit_range(u8* data, size_t sz, size_t from, size_t to, genVec_visit_fn fn, void* ctx) {
+    for (u8* p = data + (from * sz), *end = data + (to * sz); p != end; p += sz) { fn(p, ctx); }
+}
+
+static void algo_map_range(const u8* in, size_t sz, u8* out, size_t out_sz, size_t from, size_t to,
+                           genVec_map_fn fn, void* ctx)
+{
+    for (size_t i = from; i < to; i++) { fn(in + (i * sz), out + (i * out_sz), ctx); }
+}
+
+// compact the kept elms of [from, to) to from, returns how many were kept
+static size_t algo_filter_range(u8* data, size_t sz, size_t from, size_t to,
+                                genVec_pred_fn keep, genVec_delete_fn del_fn, void* ctx)
+{
+    size_t w = from;
+    for (size_t i = from; i < to; i++) {
+        u8* elm = data + (i * sz);
+        if (keep(elm, ctx)) {
+            if (w != i) { memcpy(data + (w * sz), elm, sz); }
+            w++;
+        } else if (del_fn) {
+            del_fn(elm);
+        }
+    }
+    return w - from;
+}
+
+static void algo_reduce_range(const u8* data, size_t sz, size_t from, size_t to, u8* acc,
+                              genVec_reduce_fn fn, void* ctx)
+{
+    for (size_t i = from; i < to; i++) { fn(acc, data + (i * sz), ctx); }
+}
+
+static void algo_job_visit(void* arg, size_t k) {
+    algo_job* job = arg;
+    algo_visit_range(job->data, job->sz, algo_start(&job->chunks, k), algo_end(&job->chunks, k),
+                     job->visit, job->ctx);
+}
+
+static void algo_job_map(void* arg, size_t k) {
+    algo_job* job = arg;
+    algo_map_range(job->data, job->sz, job->out, job->out_sz,
+                   algo_start(&job->chunks, k), algo_end(&job->chunks, k), job->map, job->ctx);
+}
+
+static void algo_job_filter(void* arg, size_t k) {
+    algo_job* job = arg;
+    job->kept[k] = algo_filter_range(job->data, job->sz, algo_start(&job->chunks, k),
+                                     algo_end(&job->chunks, k), job->keep, job->del_fn, job->ctx);
+}
+
+static void algo_job_reduce(void* arg, size_t k) {
+    algo_job* job = arg;
+    algo_reduce_range(job->data, job->sz, algo_start(&job->chunks, k), algo_end(&job->chunks, k),
+                      job->accs + (k * job->acc_size), job->reduce, job->ctx);
+}
+
+// delete dst's elms and make room for n, keeping its buffer (ensure unshares it)
+static int algo_prepare_dst(genVec* dst, size_t n)
+{
+    genVec_resize(dst, 0, NULL);
+    if (genVec_ensure(dst, n) != 0) { return -1; }
+    return 0;
+}
+
+
+void genVec_for_each(genVec* vec, genVec_visit_fn fn, void* ctx)
+{
+    if (GENVEC_UNLIKELY(!vec || !fn)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "for each: vec or fn is null");
+        return;
+    }
+    if (genVec_unshare(vec) != 0) { return; }
+
+    algo_visit_range(vec->data, vec->data_size, 0, vec->size, fn, ctx);
+}
+
+int genVec_map_into(const genVec* src, genVec* dst, genVec_map_fn fn, void* ctx)
+{
+    if (GENVEC_UNLIKELY(!src || !dst || !fn)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "map into: src, dst or fn is null");
+        return -1;
+    }
+
+    size_t n = src->size;
+    if (dst != src) {
+        if (GENVEC_UNLIKELY(algo_prepare_dst(dst, n) != 0)) {
+            GENVEC_FAIL(GENVEC_ERR_ALLOC, "map into: dst allocation failed");
+            return -1;
+        }
+    } else if (genVec_unshare(dst) != 0) {
+        return -1;
+    }
+
+    algo_map_range(src->data, src->data_size, dst->data, dst->data_size, 0, n, fn, ctx);
+    dst->size = n;
+    return 0;
+}
+
+size_t genVec_filter(genVec* vec, genVec_pred_fn keep, void* ctx)
+{
+    if (GENVEC_UNLIKELY(!vec || !keep)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "filter: vec or keep is null");
+        return 0;
+    }
+    if (genVec_unshare(vec) != 0) { return vec->size; }
+
+    vec->size = algo_filter_range(vec->data, vec->data_size, 0, vec->size, keep, vec->del_fn, ctx);
+    genVec_auto_shrink(vec);
+    return vec->size;
+}
+
+void genVec_reduce(const genVec* vec, u8* acc, genVec_reduce_fn fn, void* ctx)
+{
+    if (GENVEC_UNLIKELY(!vec || !acc || !fn)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "reduce: vec, acc or fn is null");
+        return;
+    }
+
+    algo_reduce_range(vec->data, vec->data_size, 0, vec->size, acc, fn, ctx);
+}
+
+
+// Parallel versions - the chunks are split across the pool (n_threads pieces at
+// most), idle threads steal whatever is left
+
+void genVec_for_each_parallel(genVec* vec, genVec_visit_fn fn, void* ctx, size_t n_threads)
+{
+    if (GENVEC_UNLIKELY(!vec || !fn)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "for each parallel: vec or fn is null");
+        return;
+    }
+    if (genVec_unshare(vec) != 0) { return; }
+
+    algo_job job = { .data = vec->data, .sz = vec->data_size, .visit = fn, .ctx = ctx };
+    algo_chunks_init(&job.chunks, vec->data, vec->size, vec->data_size);
+
+    tpool_parallel_for(tpool_default(), job.chunks.n_chunks, n_threads, algo_job_visit, &job);
+}
+
+int genVec_map_into_parallel(const genVec* src, genVec* dst, genVec_map_fn fn, void* ctx, size_t n_threads)
+{
+    if (GENVEC_UNLIKELY(!src || !dst || !fn)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "map into parallel: src, dst or fn is null");
+        return -1;
+    }
+
+    size_t n = src->size;
+    if (dst != src) {
+        if (GENVEC_UNLIKELY(algo_prepare_dst(dst, n) != 0)) {
+            GENVEC_FAIL(GENVEC_ERR_ALLOC, "map into parallel: dst allocation failed");
+            return -1;
+        }
+    } else if (genVec_unshare(dst) != 0) {
+        return -1;
+    }
+
+    // chunked on the wider of the two, those are the writes that could share lines
+    algo_job job = { .data = src->data, .out = dst->data, .sz = src->data_size,
+                     .out_sz = dst->data_size, .map = fn, .ctx = ctx };
+    if (dst->data_size >= src->data_size) {
+        algo_chunks_init(&job.chunks, dst->data, n, dst->data_size);
+    } else {
+        algo_chunks_init(&job.chunks, src->data, n, src->data_size);
+    }
+
+    tpool_parallel_for(tpool_default(), job.chunks.n_chunks, n_threads, algo_job_map, &job);
+    dst->size = n;
+    return 0;
+}
+
+size_t genVec_filter_parallel(genVec* vec, genVec_pred_fn keep, void* ctx, size_t n_threads)
+{
+    if (GENVEC_UNLIKELY(!vec || !keep)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "filter parallel: vec or keep is null");
+        return 0;
+    }
+    if (genVec_unshare(vec) != 0) { return vec->size; }
+
+    algo_job job = { .data = vec->data, .sz = vec->data_size, .del_fn = vec->del_fn,
+                     .keep = keep, .ctx = ctx };
+    algo_chunks_init(&job.chunks, vec->data, vec->size, vec->data_size);
+
+    size_t n_chunks = job.chunks.n_chunks;
+    if (n_chunks == 1) { return genVec_filter(vec, keep, ctx); }
+
+    job.kept = malloc(n_chunks * sizeof(size_t));
+    if (GENVEC_UNLIKELY(!job.kept)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "filter parallel: malloc failed");
+        return vec->size;
+    }
+
+    // every chunk compacts itself, then the kept runs slide down in order
+    tpool_parallel_for(tpool_default(), n_chunks, n_threads, algo_job_filter, &job);
+
+    size_t w = job.kept[0];
+    for (size_t k = 1; k < n_chunks; k++) {
+        size_t from = algo_start(&job.chunks, k);
+        if (job.kept[k] && w != from) {
+            memmove(vec->data + (w * vec->data_size), vec->data + (from * vec->data_size),
+                    job.kept[k] * vec->data_size);
+        }
+        w += job.kept[k];
+    }
+    free(job.kept);
+
+    vec->size = w;
+    genVec_auto_shrink(vec);
+    return w;
+}
+
+int genVec_reduce_parallel(const genVec* vec, u8* acc, size_t acc_size, genVec_reduce_fn fn,
+                           genVec_combine_fn combine, void* ctx, size_t n_threads)
+{
+    if (GENVEC_UNLIKELY(!vec || !acc || !fn || !combine)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "reduce parallel: vec, acc, fn or combine is null");
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(acc_size == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "reduce parallel: acc_size can't be 0");
+        return -1;
+    }
+
+    algo_job job = { .data = vec->data, .sz = vec->data_size, .reduce = fn, .ctx = ctx,
+                     .acc_size = acc_size };
+    algo_chunks_init(&job.chunks, vec->data, vec->size, vec->data_size);
+
+    size_t n_chunks = job.chunks.n_chunks;
+    job.accs = malloc(n_chunks * acc_size);
+    if (GENVEC_UNLIKELY(!job.accs)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "reduce parallel: malloc failed");
+        return -1;
+    }
+    for (size_t k = 0; k < n_chunks; k++) { memcpy(job.accs + (k * acc_size), acc, acc_size); }
+
+    tpool_parallel_for(tpool_default(), n_chunks, n_threads, algo_job_reduce, &job);
+
+    // combined in chunk order whatever thread ran what, so the result is repeatable
+    for (size_t k = 0; k < n_chunks; k++) { combine(acc, job.accs + (k * acc_size), ctx); }
+    free(job.accs);
+    return 0;
+}
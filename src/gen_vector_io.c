@@ -0,0 +1,141 @@
+#include "gen_vector.h"
+#include "genvec_diag.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+#define GENVEC_IO_VERSION 1
+#define GENVEC_IO_HOOKED 0x1u     // elms were written one by one through a write_fn
+
+static const char genvec_io_magic[4] = { 'G', 'V', 'E', 'C' };
+
+// stream header, written field by field so there is no padding to worry about
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint64_t data_size;
+    uint64_t size;
+} genvec_io_header;
+
+
+// Private helpers
+
+static int io_write_header(FILE* f, const genvec_io_header* h)
+{
+    return (fwrite(h->magic, sizeof(h->magic), 1, f) == 1 &&
+            fwrite(&h->version, sizeof(h->version), 1, f) == 1 &&
+            fwrite(&h->flags, sizeof(h->flags), 1, f) == 1 &&
+            fwrite(&h->data_size, sizeof(h->data_size), 1, f) == 1 &&
+            fwrite(&h->size, sizeof(h->size), 1, f) == 1) ? 0 : -1;
+}
+
+static int io_read_header(FILE* f, genvec_io_header* h)
+{
+    if (fread(h->magic, sizeof(h->magic), 1, f) != 1 ||
+        fread(&h->version, sizeof(h->version), 1, f) != 1 ||
+        fread(&h->flags, sizeof(h->flags), 1, f) != 1 ||
+        fread(&h->data_size, sizeof(h->data_size), 1, f) != 1 ||
+        fread(&h->size, sizeof(h->size), 1, f) != 1) { return -1; }
+
+    if (memcmp(h->magic, genvec_io_magic, sizeof(genvec_io_magic)) != 0) { return -1; }
+    if (h->version != GENVEC_IO_VERSION || h->data_size == 0) { return -1; }
+    return 0;
+}
+
+
+int genVec_write(const genVec* vec, FILE* f, genVec_write_fn write_fn)
+{
+    if (GENVEC_UNLIKELY(!vec || !f)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "write: vec or file is null");
+        return -1;
+    }
+    // the raw bytes of an owning elm are pointers, worthless in a file
+    if (GENVEC_UNLIKELY(vec->del_fn && !write_fn)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "write: vec has a del_fn, needs a write_fn");
+        return -1;
+    }
+
+    genvec_io_header h;
+    memcpy(h.magic, genvec_io_magic, sizeof(genvec_io_magic));
+    h.version = GENVEC_IO_VERSION;
+    h.flags = write_fn ? GENVEC_IO_HOOKED : 0;
+    h.data_size = vec->data_size;
+    h.size = vec->size;
+
+    if (GENVEC_UNLIKELY(io_write_header(f, &h) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "write: header write failed");
+        return -1;
+    }
+
+    if (!write_fn) {
+        // POD elms: one block, straight out of the buffer
+        if (GENVEC_UNLIKELY(vec->size && fwrite(vec->data, vec->data_size, vec->size, f) != vec->size)) {
+            GENVEC_FAIL(GENVEC_ERR_IO, "write: data write failed");
+            return -1;
+        }
+        return 0;
+    }
+
+    for (size_t i = 0; i < vec->size; i++) {
+        if (GENVEC_UNLIKELY(write_fn(vec->data + (i * vec->data_size), f) != 0)) {
+            GENVEC_FAIL(GENVEC_ERR_IO, "write: write_fn failed");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+genVec* genVec_read(FILE* f, size_t data_size, genVec_delete_fn del_fn, genVec_read_fn read_fn)
+{
+    if (GENVEC_UNLIKELY(!f)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "read: file is null");
+        return NULL;
+    }
+
+    genvec_io_header h;
+    if (GENVEC_UNLIKELY(io_read_header(f, &h) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "read: missing or bad header");
+        return NULL;
+    }
+    if (GENVEC_UNLIKELY(data_size && h.data_size != data_size)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "read: data_size mismatch");
+        return NULL;
+    }
+    if (GENVEC_UNLIKELY(!(h.flags & GENVEC_IO_HOOKED) != !read_fn)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "read: read_fn doesn't match how the vec was written");
+        return NULL;
+    }
+    if (GENVEC_UNLIKELY(h.size > SIZE_MAX / h.data_size)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "read: size too large");
+        return NULL;
+    }
+
+    size_t n = (size_t)h.size;
+    genVec* vec = genVec_init(n, (size_t)h.data_size, del_fn);
+    if (!vec) { return NULL; }
+
+    if (!read_fn) {
+        // one block, straight into the buffer
+        if (GENVEC_UNLIKELY(n && fread(vec->data, vec->data_size, n, f) != n)) {
+            GENVEC_FAIL(GENVEC_ERR_IO, "read: data truncated");
+            genVec_destroy(vec);
+            return NULL;
+        }
+        vec->size = n;
+        return vec;
+    }
+
+    // size only counts fully read elms, so destroy cleans up exactly those
+    for (size_t i = 0; i < n; i++) {
+        if (GENVEC_UNLIKELY(read_fn(vec->data + (i * vec->data_size), f) != 0)) {
+            GENVEC_FAIL(GENVEC_ERR_IO, "read: read_fn failed");
+            genVec_destroy(vec);
+            return NULL;
+        }
+        vec->size++;
+    }
+    return vec;
+}
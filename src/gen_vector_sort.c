@@ -0,0 +1,362 @@
+#include "gen_vector.h"
+#include "thread_pool.h"
+#include "genvec_diag.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// runs this short are insertion sorted
+#define SORT_INSERTION_MAX 16
+// below this many elms splitting across threads isn't worth it
+#define SORT_PARALLEL_MIN (1u << 16)
+#define SORT_MAX_THREADS 64
+
+
+// Private helpers - everything works on (base, n, elm size) ranges
+
+static inline void* sort_alloc(const genVec_allocator* alloc, size_t size) {
+    return alloc ? alloc->alloc(alloc->ctx, size) : malloc(size);
+}
+
+static inline void sort_free(const genVec_allocator* alloc, void* ptr, size_t size) {
+    if (alloc) { alloc->free(alloc->ctx, ptr, size); }
+    else       { free(ptr); }
+}
+
+// a mapped vec's allocator resizes its file, the temp buffer comes from malloc then
+static inline const genVec_allocator* sort_tmp_alloc(const genVec* vec) {
+    return (vec->flags & GENVEC_MAPPED) ? NULL : vec->alloc;
+}
+
+// fixed size cases compile to plain register moves, no temp elm buffer needed
+static inline void elm_swap(u8* a, u8* b, size_t sz)
+{
+    switch (sz) {
+    case 1: { u8 t = *a; *a = *b; *b = t; return; }
+    case 2: { uint16_t t; memcpy(&t, a, 2); memcpy(a, b, 2); memcpy(b, &t, 2); return; }
+    case 4: { uint32_t t; memcpy(&t, a, 4); memcpy(a, b, 4); memcpy(b, &t, 4); return; }
+    case 8: { uint64_t t; memcpy(&t, a, 8); memcpy(a, b, 8); memcpy(b, &t, 8); return; }
+    case 16: {
+        uint64_t t[2];
+        memcpy(t, a, 16); memcpy(a, b, 16); memcpy(b, t, 16);
+        return;
+    }
+    default: {
+        // bigger records go through a small stack buffer, a chunk at a time
+        u8 t[64];
+        while (sz > 0) {
+            size_t c = sz < sizeof(t) ? sz : sizeof(t);
+            memcpy(t, a, c); memcpy(a, b, c); memcpy(b, t, c);
+            a += c; b += c; sz -= c;
+        }
+    }
+    }
+}
+
+// stable, only swaps strictly out of order neighbours
+static void insertion_sort(u8* base, size_t n, size_t sz, genVec_compare_fn cmp)
+{
+    for (size_t i = 1; i < n; i++) {
+        u8* p = base + (i * sz);
+        while (p > base && cmp(p - sz, p) > 0) {
+            elm_swap(p - sz, p, sz);
+            p -= sz;
+        }
+    }
+}
+
+static void sift_down(u8* base, size_t root, size_t n, size_t sz, genVec_compare_fn cmp)
+{
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= n) { return; }
+        if (child + 1 < n && cmp(base + (child * sz), base + ((child + 1) * sz)) < 0) { child++; }
+        if (cmp(base + (root * sz), base + (child * sz)) >= 0) { return; }
+
+        elm_swap(base + (root * sz), base + (child * sz), sz);
+        root = child;
+    }
+}
+
+static void heap_sort(u8* base, size_t n, size_t sz, genVec_compare_fn cmp)
+{
+    for (size_t i = n / 2; i-- > 0;) { sift_down(base, i, n, sz, cmp); }
+    for (size_t end = n - 1; end > 0; end--) {
+        elm_swap(base, base + (end * sz), sz);
+        sift_down(base, 0, end, sz, cmp);
+    }
+}
+
+// orders a <= b <= c
+static inline void sort3(u8* a, u8* b, u8* c, size_t sz, genVec_compare_fn cmp)
+{
+    if (cmp(b, a) < 0) { elm_swap(a, b, sz); }
+    if (cmp(c, b) < 0) {
+        elm_swap(b, c, sz);
+        if (cmp(b, a) < 0) { elm_swap(a, b, sz); }
+    }
+}
+
+// quicksort, heapsort once depth runs out, insertion sort for short runs
+static void intro_sort(u8* base, size_t n, size_t sz, genVec_compare_fn cmp, int depth)
+{
+    while (n > SORT_INSERTION_MAX) {
+        if (depth-- == 0) {
+            heap_sort(base, n, sz, cmp);
+            return;
+        }
+
+        // median of three ends up at base[0], last elm is >= it and stops the left scan
+        u8* mid = base + ((n / 2) * sz);
+        u8* last = base + ((n - 1) * sz);
+        sort3(base, mid, last, sz, cmp);
+        elm_swap(base, mid, sz);
+
+        // Hoare partition, both scans stop on equal elms so runs of
+        // duplicates still split in the middle
+        size_t i = 0, j = n;
+        for (;;) {
+            do { i++; } while (cmp(base + (i * sz), base) < 0);
+            do { j--; } while (cmp(base, base + (j * sz)) < 0);
+            if (i >= j) { break; }
+            elm_swap(base + (i * sz), base + (j * sz), sz);
+        }
+        elm_swap(base, base + (j * sz), sz);
+
+        // recurse into the smaller side, loop on the bigger one
+        size_t left = j, right = n - j - 1;
+        if (left < right) {
+            intro_sort(base, left, sz, cmp, depth);
+            base += (j + 1) * sz;
+            n = right;
+        } else {
+            intro_sort(base + ((j + 1) * sz), right, sz, cmp, depth);
+            n = left;
+        }
+    }
+    insertion_sort(base, n, sz, cmp);
+}
+
+static int sort_depth(size_t n) {
+    int depth = 0;
+    while (n > 1) { n >>= 1; depth++; }
+    return 2 * depth;
+}
+
+static void sort_range(u8* base, size_t n, size_t sz, genVec_compare_fn cmp) {
+    if (n > 1) { intro_sort(base, n, sz, cmp, sort_depth(n)); }
+}
+
+// merge sorted [a, a + na) and [b, b + nb) into out, ties taken from a (stable)
+static void merge_runs(const u8* a, size_t na, const u8* b, size_t nb, u8* out, size_t sz, genVec_compare_fn cmp)
+{
+    const u8* a_end = a + (na * sz);
+    const u8* b_end = b + (nb * sz);
+
+    while (a < a_end && b < b_end) {
+        if (cmp(b, a) < 0) { memcpy(out, b, sz); b += sz; }
+        else               { memcpy(out, a, sz); a += sz; }
+        out += sz;
+    }
+    if (a < a_end) { memcpy(out, a, (size_t)(a_end - a)); out += a_end - a; }
+    if (b < b_end) { memcpy(out, b, (size_t)(b_end - b)); }
+}
+
+// bottom up merge sort of base using tmp (n elms), result ends up in base
+static void merge_sort(u8* base, u8* tmp, size_t n, size_t sz, genVec_compare_fn cmp)
+{
+    for (size_t i = 0; i < n; i += SORT_INSERTION_MAX) {
+        size_t run = n - i < SORT_INSERTION_MAX ? n - i : SORT_INSERTION_MAX;
+        insertion_sort(base + (i * sz), run, sz, cmp);
+    }
+
+    u8* src = base;
+    u8* dst = tmp;
+    for (size_t width = SORT_INSERTION_MAX; width < n; width *= 2) {
+        for (size_t i = 0; i < n; i += 2 * width) {
+            size_t na = n - i < width ? n - i : width;
+            size_t nb = n - i - na < width ? n - i - na : width;
+            merge_runs(src + (i * sz), na, src + ((i + na) * sz), nb, dst + (i * sz), sz, cmp);
+        }
+        u8* t = src; src = dst; dst = t;
+    }
+
+    if (src != base) { memcpy(base, src, n * sz); }
+}
+
+
+void genVec_sort(genVec* vec, genVec_compare_fn cmp)
+{
+    if (GENVEC_UNLIKELY(!vec || !cmp)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "sort: vec or cmp is null");
+        return;
+    }
+    if (genVec_unshare(vec) != 0) { return; }
+
+    sort_range(vec->data, vec->size, vec->data_size, cmp);
+}
+
+void genVec_stable_sort(genVec* vec, genVec_compare_fn cmp)
+{
+    if (GENVEC_UNLIKELY(!vec || !cmp)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "stable sort: vec or cmp is null");
+        return;
+    }
+    if (genVec_unshare(vec) != 0) { return; }
+    if (vec->size <= SORT_INSERTION_MAX) {
+        insertion_sort(vec->data, vec->size, vec->data_size, cmp);
+        return;
+    }
+
+    size_t bytes = vec->size * vec->data_size;
+    u8* tmp = sort_alloc(sort_tmp_alloc(vec), bytes);
+    if (GENVEC_UNLIKELY(!tmp)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "stable sort: tmp buffer alloc failed");
+        return;
+    }
+
+    merge_sort(vec->data, tmp, vec->size, vec->data_size, cmp);
+    sort_free(sort_tmp_alloc(vec), tmp, bytes);
+}
+
+size_t genVec_lower_bound(const genVec* vec, const u8* key, genVec_compare_fn cmp)
+{
+    if (GENVEC_UNLIKELY(!vec || !key || !cmp)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "lower bound: invalid parameters");
+        return 0;
+    }
+
+    // first elm that is not < key
+    size_t lo = 0, n = vec->size;
+    while (n > 0) {
+        size_t half = n / 2;
+        if (cmp(vec->data + ((lo + half) * vec->data_size), key) < 0) {
+            lo += half + 1;
+            n -= half + 1;
+        } else {
+            n = half;
+        }
+    }
+    return lo;
+}
+
+size_t genVec_upper_bound(const genVec* vec, const u8* key, genVec_compare_fn cmp)
+{
+    if (GENVEC_UNLIKELY(!vec || !key || !cmp)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "upper bound: invalid parameters");
+        return 0;
+    }
+
+    // first elm that is > key
+    size_t lo = 0, n = vec->size;
+    while (n > 0) {
+        size_t half = n / 2;
+        if (cmp(key, vec->data + ((lo + half) * vec->data_size)) >= 0) {
+            lo += half + 1;
+            n -= half + 1;
+        } else {
+            n = half;
+        }
+    }
+    return lo;
+}
+
+u8* genVec_bsearch(const genVec* vec, const u8* key, genVec_compare_fn cmp)
+{
+    size_t i = genVec_lower_bound(vec, key, cmp);
+    if (!vec || i >= vec->size) { return NULL; }
+
+    u8* elm = vec->data + (i * vec->data_size);
+    return cmp(elm, key) == 0 ? elm : NULL;
+}
+
+
+// Parallel sort: each slice is sorted as a pool task, then slices are merged
+// pairwise (one task per pair) until one run is left
+
+typedef struct {
+    u8* src;
+    u8* dst;
+    size_t start, mid, end;     // sort: [start, end), merge: [start, mid) + [mid, end)
+    size_t sz;
+    genVec_compare_fn cmp;
+} sort_job;
+
+static void sort_job_sort(void* ctx, size_t i) {
+    sort_job* job = (sort_job*)ctx + i;
+    sort_range(job->src + (job->start * job->sz), job->end - job->start, job->sz, job->cmp);
+}
+
+static void sort_job_merge(void* ctx, size_t i) {
+    sort_job* job = (sort_job*)ctx + i;
+    merge_runs(job->src + (job->start * job->sz), job->mid - job->start,
+               job->src + (job->mid * job->sz), job->end - job->mid,
+               job->dst + (job->start * job->sz), job->sz, job->cmp);
+}
+
+void genVec_sort_parallel(genVec* vec, genVec_compare_fn cmp, size_t n_threads)
+{
+    if (GENVEC_UNLIKELY(!vec || !cmp)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "sort parallel: vec or cmp is null");
+        return;
+    }
+    if (genVec_unshare(vec) != 0) { return; }
+
+    ThreadPool* pool = tpool_default();
+    if (n_threads == 0) { n_threads = tpool_size(pool); }
+    if (n_threads > SORT_MAX_THREADS) { n_threads = SORT_MAX_THREADS; }
+
+    size_t n = vec->size;
+    size_t sz = vec->data_size;
+    if (n_threads < 2 || n < SORT_PARALLEL_MIN) {
+        sort_range(vec->data, n, sz, cmp);
+        return;
+    }
+
+    size_t bytes = n * sz;
+    u8* tmp = sort_alloc(sort_tmp_alloc(vec), bytes);
+    if (!tmp) {
+        // still sorted, just on one thread
+        sort_range(vec->data, n, sz, cmp);
+        return;
+    }
+
+    size_t bounds[SORT_MAX_THREADS + 1];
+    sort_job jobs[SORT_MAX_THREADS];
+
+    size_t runs = n_threads;
+    for (size_t i = 0; i <= runs; i++) { bounds[i] = (n / runs) * i + (i * (n % runs)) / runs; }
+
+    for (size_t i = 0; i < runs; i++) {
+        jobs[i] = (sort_job){ vec->data, NULL, bounds[i], 0, bounds[i + 1], sz, cmp };
+    }
+    tpool_parallel_for(pool, runs, 0, sort_job_sort, jobs);
+
+    u8* src = vec->data;
+    u8* dst = tmp;
+    while (runs > 1) {
+        size_t pairs = runs / 2;
+        for (size_t p = 0; p < pairs; p++) {
+            jobs[p] = (sort_job){ src, dst, bounds[2 * p], bounds[2 * p + 1], bounds[2 * p + 2], sz, cmp };
+        }
+        tpool_parallel_for(pool, pairs, 0, sort_job_merge, jobs);
+
+        // an odd run out just gets copied along
+        if (runs % 2) {
+            memcpy(dst + (bounds[runs - 1] * sz), src + (bounds[runs - 1] * sz),
+                   (bounds[runs] - bounds[runs - 1]) * sz);
+        }
+
+        // drop the merged boundaries
+        size_t next = 0;
+        for (size_t i = 0; i <= runs; i += 2) { bounds[next++] = bounds[i]; }
+        if (runs % 2) { bounds[next++] = bounds[runs]; }
+        runs = next - 1;
+
+        u8* t = src; src = dst; dst = t;
+    }
+
+    if (src != vec->data) { memcpy(vec->data, src, bytes); }
+    sort_free(sort_tmp_alloc(vec), tmp, bytes);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "genvec_error.h"
+
+
+// Private error path helpers for the library sources.
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define GENVEC_LIKELY(x)   __builtin_expect(!!(x), 1)
+    #define GENVEC_UNLIKELY(x) __builtin_expect(!!(x), 0)
+    #define GENVEC_COLD        __attribute__((cold, noinline))
+#else
+    #define GENVEC_LIKELY(x)   (x)
+    #define GENVEC_UNLIKELY(x) (x)
+    #define GENVEC_COLD
+#endif
+
+// records err, and prints msg when diagnostics are on (out of line, so the
+// hot path only pays for the branch)
+GENVEC_COLD void genVec_fail_(genVec_error err, const char* msg);
+
+// records err only, for outcomes callers expect (a drain loop hitting empty)
+GENVEC_COLD void genVec_fail_quiet_(genVec_error err);
+
+#ifdef GENVEC_NO_DIAGNOSTICS
+    #define GENVEC_FAIL(err, msg) ((void)(msg), genVec_fail_((err), NULL))   // msg still counts as used
+#else
+    #define GENVEC_FAIL(err, msg) genVec_fail_((err), (msg))
+#endif
+
+#define GENVEC_FAIL_QUIET(err) genVec_fail_quiet_(err)
+
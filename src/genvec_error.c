@@ -0,0 +1,52 @@
+#include "genvec_diag.h"
+
+#include <stdio.h>
+
+
+static __thread genVec_error last_error = GENVEC_OK;
+static __thread const char* last_msg = NULL;
+
+
+void genVec_fail_(genVec_error err, const char* msg)
+{
+    last_error = err;
+    last_msg = msg;
+
+#ifndef GENVEC_NO_DIAGNOSTICS
+    if (msg) { printf("%s\n", msg); }
+#endif
+}
+
+void genVec_fail_quiet_(genVec_error err) {
+    last_error = err;
+    last_msg = NULL;
+}
+
+
+genVec_error genVec_last_error(void) {
+    return last_error;
+}
+
+const char* genVec_last_error_msg(void) {
+    if (last_msg) { return last_msg; }
+    return last_error == GENVEC_OK ? "" : genVec_error_str(last_error);
+}
+
+void genVec_clear_error(void) {
+    last_error = GENVEC_OK;
+    last_msg = NULL;
+}
+
+const char* genVec_error_str(genVec_error err)
+{
+    switch (err) {
+        case GENVEC_OK:          return "ok";
+        case GENVEC_ERR_NULL:    return "null pointer";
+        case GENVEC_ERR_BOUNDS:  return "out of bounds";
+        case GENVEC_ERR_EMPTY:   return "empty";
+        case GENVEC_ERR_ALLOC:   return "allocation failed";
+        case GENVEC_ERR_INVALID: return "invalid argument";
+        case GENVEC_ERR_IO:      return "i/o error";
+    }
+    return "unknown error";
+}
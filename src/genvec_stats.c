@@ -0,0 +1,153 @@
+#include "gen_vector.h"
+#include "genvec_stats_hooks.h"
+#include "genvec_diag.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+static genVec_stats global_stats;               // every field is a relaxed atomic
+static genVec_trace_fn trace_fn = NULL;         // atomic
+static void* trace_ctx = NULL;
+
+
+// Private helpers
+
+#ifdef GENVEC_STATS
+
+static inline void stat_add(uint64_t* counter, uint64_t v) {
+    __atomic_add_fetch(counter, v, __ATOMIC_RELAXED);
+}
+
+static inline void stat_max(uint64_t* counter, uint64_t v)
+{
+    uint64_t cur = __atomic_load_n(counter, __ATOMIC_RELAXED);
+    while (v > cur && !__atomic_compare_exchange_n(counter, &cur, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+static inline void stat_trace(genVec_event ev, const genVec* vec, size_t a, size_t b)
+{
+    genVec_trace_fn fn = __atomic_load_n(&trace_fn, __ATOMIC_ACQUIRE);
+    if (GENVEC_UNLIKELY(fn != NULL)) { fn(ev, vec, a, b, trace_ctx); }
+}
+
+void genVec_stats_resize_(genVec* vec, size_t old_cap, size_t new_cap)
+{
+    genVec_stats* s = &vec->stats;
+    uint64_t bytes = (uint64_t)new_cap * vec->data_size;
+    int grow = new_cap > old_cap;
+
+    if (grow) { s->grows++; stat_add(&global_stats.grows, 1); }
+    else      { s->shrinks++; stat_add(&global_stats.shrinks, 1); }
+    s->realloc_bytes += bytes;
+    stat_add(&global_stats.realloc_bytes, bytes);
+
+    if (new_cap > s->peak_capacity) { s->peak_capacity = new_cap; }
+    stat_max(&global_stats.peak_capacity, bytes);
+
+    stat_trace(grow ? GENVEC_EV_GROW : GENVEC_EV_SHRINK, vec, old_cap, new_cap);
+}
+
+void genVec_stats_move_(genVec* vec, size_t bytes)
+{
+    vec->stats.moved_bytes += bytes;
+    stat_add(&global_stats.moved_bytes, bytes);
+    stat_trace(GENVEC_EV_MOVE, vec, bytes, 0);
+}
+
+void genVec_stats_string_(genVec* vec, genVec_event ev, size_t bytes)
+{
+    if (ev == GENVEC_EV_STR_APPEND) {
+        vec->stats.str_appends++;
+        stat_add(&global_stats.str_appends, 1);
+    } else {
+        vec->stats.str_inserts++;
+        stat_add(&global_stats.str_inserts, 1);
+    }
+    stat_trace(ev, vec, bytes, 0);
+}
+
+#endif
+
+
+int genVec_stats_enabled(void) {
+#ifdef GENVEC_STATS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void genVec_stats_get(const genVec* vec, genVec_stats* out)
+{
+    if (GENVEC_UNLIKELY(!vec || !out)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "stats get: vec or out is null");
+        return;
+    }
+#ifdef GENVEC_STATS
+    *out = vec->stats;
+#else
+    memset(out, 0, sizeof(*out));
+#endif
+}
+
+void genVec_stats_reset_vec(genVec* vec)
+{
+    if (GENVEC_UNLIKELY(!vec)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "stats reset vec: vec is null");
+        return;
+    }
+#ifdef GENVEC_STATS
+    memset(&vec->stats, 0, sizeof(vec->stats));
+#endif
+}
+
+void genVec_stats_global(genVec_stats* out)
+{
+    if (GENVEC_UNLIKELY(!out)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "stats global: out is null");
+        return;
+    }
+
+    // field by field, so a snapshot taken while others count isn't one instant
+    out->grows = __atomic_load_n(&global_stats.grows, __ATOMIC_RELAXED);
+    out->shrinks = __atomic_load_n(&global_stats.shrinks, __ATOMIC_RELAXED);
+    out->realloc_bytes = __atomic_load_n(&global_stats.realloc_bytes, __ATOMIC_RELAXED);
+    out->moved_bytes = __atomic_load_n(&global_stats.moved_bytes, __ATOMIC_RELAXED);
+    out->peak_capacity = __atomic_load_n(&global_stats.peak_capacity, __ATOMIC_RELAXED);
+    out->str_appends = __atomic_load_n(&global_stats.str_appends, __ATOMIC_RELAXED);
+    out->str_inserts = __atomic_load_n(&global_stats.str_inserts, __ATOMIC_RELAXED);
+}
+
+void genVec_stats_reset(void)
+{
+    __atomic_store_n(&global_stats.grows, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&global_stats.shrinks, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&global_stats.realloc_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&global_stats.moved_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&global_stats.peak_capacity, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&global_stats.str_appends, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&global_stats.str_inserts, 0, __ATOMIC_RELAXED);
+}
+
+void genVec_stats_dump(FILE* f, const char* label, const genVec_stats* s)
+{
+    if (GENVEC_UNLIKELY(!f || !s)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "stats dump: file or stats is null");
+        return;
+    }
+
+    fprintf(f, "%s%sgrows=%llu shrinks=%llu realloc_bytes=%llu moved_bytes=%llu "
+               "peak_capacity=%llu str_appends=%llu str_inserts=%llu\n",
+            label ? label : "", label ? ": " : "",
+            (unsigned long long)s->grows, (unsigned long long)s->shrinks,
+            (unsigned long long)s->realloc_bytes, (unsigned long long)s->moved_bytes,
+            (unsigned long long)s->peak_capacity, (unsigned long long)s->str_appends,
+            (unsigned long long)s->str_inserts);
+}
+
+void genVec_stats_set_trace(genVec_trace_fn fn, void* ctx)
+{
+    trace_ctx = ctx;
+    __atomic_store_n(&trace_fn, fn, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "gen_vector.h"
+
+
+// Private stats hooks for the library sources, they vanish without GENVEC_STATS.
+
+#ifdef GENVEC_STATS
+    void genVec_stats_resize_(genVec* vec, size_t old_cap, size_t new_cap);
+    void genVec_stats_move_(genVec* vec, size_t bytes);
+    void genVec_stats_string_(genVec* vec, genVec_event ev, size_t bytes);
+
+    #define GENVEC_STAT_RESIZE(vec, old_cap, new_cap) genVec_stats_resize_((vec), (old_cap), (new_cap))
+    #define GENVEC_STAT_MOVE(vec, bytes)              genVec_stats_move_((vec), (bytes))
+    #define GENVEC_STAT_STRING(vec, ev, bytes)        genVec_stats_string_((vec), (ev), (bytes))
+#else
+    #define GENVEC_STAT_RESIZE(vec, old_cap, new_cap) ((void)0)
+    #define GENVEC_STAT_MOVE(vec, bytes)              ((void)0)
+    #define GENVEC_STAT_STRING(vec, ev, bytes)        ((void)0)
+#endif
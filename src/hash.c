@@ -0,0 +1,114 @@
+#include "hash.h"
+
+#include <string.h>
+
+
+static const uint64_t hash_secret[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+    0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+};
+
+
+// Private helpers
+
+// 64x64 -> 128 multiply, lo and hi halves returned through a and b
+static inline void hash_mum(uint64_t* a, uint64_t* b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t hash_mix(uint64_t a, uint64_t b) {
+    hash_mum(&a, &b);
+    return a ^ b;
+}
+
+// unaligned little endian reads
+static inline uint64_t hash_r8(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline uint64_t hash_r4(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+// 1..3 bytes
+static inline uint64_t hash_r3(const uint8_t* p, size_t k) {
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+
+uint64_t hash_bytes(const void* data, size_t len, uint64_t seed)
+{
+    const uint8_t* p = data;
+    uint64_t a, b;
+
+    seed ^= hash_mix(seed ^ hash_secret[0], hash_secret[1]);
+
+    if (len <= 16) {
+        if (len >= 4) {
+            // two overlapping 4 byte reads from each end cover 4..16 bytes
+            size_t mid = (len >> 3) << 2;
+            a = (hash_r4(p) << 32) | hash_r4(p + mid);
+            b = (hash_r4(p + len - 4) << 32) | hash_r4(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = hash_r3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            // three independent lanes so the multiplies can overlap
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = hash_mix(hash_r8(p) ^ hash_secret[1], hash_r8(p + 8) ^ seed);
+                see1 = hash_mix(hash_r8(p + 16) ^ hash_secret[2], hash_r8(p + 24) ^ see1);
+                see2 = hash_mix(hash_r8(p + 32) ^ hash_secret[3], hash_r8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = hash_mix(hash_r8(p) ^ hash_secret[1], hash_r8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        // last 16 bytes, overlapping what was already consumed
+        a = hash_r8(p + i - 16);
+        b = hash_r8(p + i - 8);
+    }
+
+    a ^= hash_secret[1];
+    b ^= seed;
+    hash_mum(&a, &b);
+    return hash_mix(a ^ hash_secret[0] ^ len, b ^ hash_secret[1]);
+}
+
+uint64_t hash_cstr(const char* cstr, uint64_t seed) {
+    return cstr ? hash_bytes(cstr, strlen(cstr), seed) : 0;
+}
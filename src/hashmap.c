@@ -0,0 +1,377 @@
+#include "hashmap.h"
+#include "String.h"
+#include "genvec_diag.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// control bytes: 0xxxxxxx full (low 7 hash bits), EMPTY and DELETED have the top bit set
+#define CTRL_EMPTY   ((u8)0x80)
+#define CTRL_DELETED ((u8)0xFE)
+
+#define GROUP_WIDTH  8      // slots checked per probe step (one 64 bit word)
+#define MIN_CAPACITY 8
+
+#define LSBS 0x0101010101010101ULL
+#define MSBS 0x8080808080808080ULL
+
+
+// Private helpers
+
+// a group is GROUP_WIDTH control bytes, one per byte of a word (byte 0 = first slot)
+static inline uint64_t group_load(const u8* ctrl) {
+    uint64_t g;
+    memcpy(&g, ctrl, sizeof(g));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    g = __builtin_bswap64(g);
+#endif
+    return g;
+}
+
+// high bit set in every byte equal to h2 (can have false positives right
+// after a real match, harmless since keys are compared anyway)
+static inline uint64_t group_match(uint64_t g, u8 h2) {
+    uint64_t x = g ^ (LSBS * h2);
+    return (x - LSBS) & ~x & MSBS;
+}
+
+static inline uint64_t group_match_empty(uint64_t g) {
+    return g & (~g << 6) & MSBS;
+}
+
+static inline uint64_t group_match_empty_or_deleted(uint64_t g) {
+    return g & (~g << 7) & MSBS;
+}
+
+// index of the lowest matched byte, mask must be nonzero
+static inline size_t group_first(uint64_t mask) {
+    return (size_t)__builtin_ctzll(mask) >> 3;
+}
+
+static inline u8* map_ctrl(const HashMap* map) {
+    return map->ctrl.data;
+}
+
+static inline u8* map_key(const HashMap* map, size_t i) {
+    return map->keys.data + (i * map->key_size);
+}
+
+static inline u8* map_val(const HashMap* map, size_t i) {
+    return map->val_size ? map->vals.data + (i * map->val_size) : NULL;
+}
+
+static inline uint64_t map_hash(const HashMap* map, const u8* key) {
+    return map->hash_fn ? map->hash_fn(key, map->key_size) : hash_bytes(key, map->key_size, HASH_DEFAULT_SEED);
+}
+
+static inline int map_eq(const HashMap* map, const u8* a, const u8* b) {
+    return map->eq_fn ? map->eq_fn(a, b, map->key_size) : memcmp(a, b, map->key_size) == 0;
+}
+
+// h1 picks the start slot, h2 (low 7 bits) goes in the control byte
+static inline size_t hash_h1(uint64_t h) { return (size_t)(h >> 7); }
+static inline u8 hash_h2(uint64_t h) { return (u8)(h & 0x7F); }
+
+// 7/8 max load
+static inline size_t capacity_to_growth(size_t capacity) {
+    return capacity - capacity / 8;
+}
+
+// writes a control byte, slots in the first group are mirrored past the end
+// so a group load starting anywhere never has to wrap
+static inline void set_ctrl(HashMap* map, size_t i, u8 c) {
+    u8* ctrl = map_ctrl(map);
+    ctrl[i] = c;
+    if (i < GROUP_WIDTH) { ctrl[map->capacity + i] = c; }
+}
+
+// slot holding key, or capacity if it isn't in the map
+static size_t map_find(const HashMap* map, const u8* key, uint64_t h)
+{
+    if (map->capacity == 0) { return 0; }
+
+    size_t mask = map->capacity - 1;
+    size_t pos = hash_h1(h) & mask;
+    size_t step = 0;
+    u8 h2 = hash_h2(h);
+
+    // triangular probing over groups visits every group once for power of 2 sizes
+    for (;;) {
+        uint64_t g = group_load(map_ctrl(map) + pos);
+
+        for (uint64_t m = group_match(g, h2); m; m &= m - 1) {
+            size_t i = (pos + group_first(m)) & mask;
+            if (map_eq(map, map_key(map, i), key)) { return i; }
+        }
+        // an empty slot ends the probe chain, the key would have gone there
+        if (group_match_empty(g)) { return map->capacity; }
+
+        step += GROUP_WIDTH;
+        pos = (pos + step) & mask;
+    }
+}
+
+// first empty or deleted slot on the probe chain of h
+static size_t map_find_free(const HashMap* map, uint64_t h)
+{
+    size_t mask = map->capacity - 1;
+    size_t pos = hash_h1(h) & mask;
+    size_t step = 0;
+
+    for (;;) {
+        uint64_t m = group_match_empty_or_deleted(group_load(map_ctrl(map) + pos));
+        if (m) { return (pos + group_first(m)) & mask; }
+
+        step += GROUP_WIDTH;
+        pos = (pos + step) & mask;
+    }
+}
+
+// move every entry into fresh arrays of new_cap slots (also drops tombstones)
+static int map_rehash(HashMap* map, size_t new_cap)
+{
+    genVec ctrl, keys, vals;
+
+    if (genVec_init_inplace(&ctrl, new_cap + GROUP_WIDTH, 1, NULL) != 0) { return -1; }
+    if (genVec_init_inplace(&keys, new_cap, map->key_size, NULL) != 0) {
+        genVec_deinit(&ctrl);
+        return -1;
+    }
+    if (genVec_init_inplace(&vals, map->val_size ? new_cap : 0, map->val_size ? map->val_size : 1, NULL) != 0) {
+        genVec_deinit(&ctrl);
+        genVec_deinit(&keys);
+        return -1;
+    }
+
+    ctrl.size = new_cap + GROUP_WIDTH;
+    keys.size = new_cap;
+    vals.size = map->val_size ? new_cap : 0;
+    memset(ctrl.data, CTRL_EMPTY, ctrl.size);
+
+    HashMap old = *map;
+    map->ctrl = ctrl;
+    map->keys = keys;
+    map->vals = vals;
+    map->capacity = new_cap;
+    map->growth_left = capacity_to_growth(new_cap) - map->size;
+
+    // entries are moved bytewise, nothing is deleted
+    for (size_t i = 0; i < old.capacity; i++) {
+        if (map_ctrl(&old)[i] & 0x80) { continue; }
+
+        uint64_t h = map_hash(map, map_key(&old, i));
+        size_t slot = map_find_free(map, h);
+
+        set_ctrl(map, slot, hash_h2(h));
+        memcpy(map_key(map, slot), map_key(&old, i), map->key_size);
+        if (map->val_size) { memcpy(map_val(map, slot), map_val(&old, i), map->val_size); }
+    }
+
+    genVec_deinit(&old.ctrl);
+    genVec_deinit(&old.keys);
+    genVec_deinit(&old.vals);
+    return 0;
+}
+
+// run the delete fns on every full slot
+static void map_delete_all(HashMap* map)
+{
+    if (!map->key_del && !map->val_del) { return; }
+
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (map_ctrl(map)[i] & 0x80) { continue; }
+        if (map->key_del) { map->key_del(map_key(map, i)); }
+        if (map->val_del) { map->val_del(map_val(map, i)); }
+    }
+}
+
+
+HashMap* hashmap_create(size_t key_size, size_t val_size, hashmap_hash_fn hash_fn, hashmap_eq_fn eq_fn,
+                        genVec_delete_fn key_del, genVec_delete_fn val_del)
+{
+    if (GENVEC_UNLIKELY(key_size == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "hashmap create: key_size can't be 0");
+        return NULL;
+    }
+
+    HashMap* map = malloc(sizeof(HashMap));
+    if (GENVEC_UNLIKELY(!map)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "hashmap create: malloc failed");
+        return NULL;
+    }
+
+    // storage is allocated on the first insert
+    genVec_init_inplace(&map->ctrl, 0, 1, NULL);
+    genVec_init_inplace(&map->keys, 0, key_size, NULL);
+    genVec_init_inplace(&map->vals, 0, val_size ? val_size : 1, NULL);
+
+    map->size = 0;
+    map->capacity = 0;
+    map->growth_left = 0;
+    map->key_size = key_size;
+    map->val_size = val_size;
+    map->hash_fn = hash_fn;
+    map->eq_fn = eq_fn;
+    map->key_del = key_del;
+    map->val_del = val_size ? val_del : NULL;   // a set has no values to delete
+
+    return map;
+}
+
+void hashmap_destroy(HashMap* map)
+{
+    if (!map) { return; }
+
+    map_delete_all(map);
+    genVec_deinit(&map->ctrl);
+    genVec_deinit(&map->keys);
+    genVec_deinit(&map->vals);
+    free(map);
+}
+
+void hashmap_clear(HashMap* map)
+{
+    if (GENVEC_UNLIKELY(!map)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "hashmap clear: map is null");
+        return;
+    }
+    if (map->capacity == 0) { return; }
+
+    map_delete_all(map);
+    memset(map_ctrl(map), CTRL_EMPTY, map->capacity + GROUP_WIDTH);
+    map->size = 0;
+    map->growth_left = capacity_to_growth(map->capacity);
+}
+
+int hashmap_reserve(HashMap* map, size_t n)
+{
+    if (GENVEC_UNLIKELY(!map)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "hashmap reserve: map is null");
+        return -1;
+    }
+
+    if (map->capacity > 0 && capacity_to_growth(map->capacity) >= n) { return 0; }
+
+    // a slot is its ctrl byte, key and value, stop before cap or its bytes wrap
+    size_t slot_size = 1 + map->key_size + map->val_size;
+    size_t cap = MIN_CAPACITY;
+    while (capacity_to_growth(cap) < n) {
+        if (GENVEC_UNLIKELY(cap >= SIZE_MAX / 2 / slot_size)) {
+            GENVEC_FAIL(GENVEC_ERR_ALLOC, "hashmap reserve: n is too large");
+            return -1;
+        }
+        cap <<= 1;
+    }
+    if (cap <= map->capacity) { return 0; }
+
+    return map_rehash(map, cap);
+}
+
+int hashmap_insert(HashMap* map, const u8* key, const u8* val)
+{
+    if (GENVEC_UNLIKELY(!map || !key || (!val && map->val_size))) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "hashmap insert: invalid parameters");
+        return -1;
+    }
+
+    uint64_t h = map_hash(map, key);
+
+    size_t i = map_find(map, key, h);
+    if (i < map->capacity) {
+        // replace, the map owned the old key and value
+        if (map->key_del) { map->key_del(map_key(map, i)); }
+        if (map->val_del) { map->val_del(map_val(map, i)); }
+        memcpy(map_key(map, i), key, map->key_size);
+        if (map->val_size) { memcpy(map_val(map, i), val, map->val_size); }
+        return 0;
+    }
+
+    if (map->capacity == 0) {
+        if (map_rehash(map, MIN_CAPACITY) != 0) { return -1; }
+    }
+
+    i = map_find_free(map, h);
+    if (map->growth_left == 0 && map_ctrl(map)[i] == CTRL_EMPTY) {
+        // mostly tombstones: clean up in place, otherwise double
+        size_t new_cap = map->size * 2 < capacity_to_growth(map->capacity) ? map->capacity : map->capacity * 2;
+        if (GENVEC_UNLIKELY(map_rehash(map, new_cap) != 0)) {
+            GENVEC_FAIL(GENVEC_ERR_ALLOC, "hashmap insert: rehash failed");
+            return -1;
+        }
+        i = map_find_free(map, h);
+    }
+
+    // reusing a tombstone doesn't use up growth
+    if (map_ctrl(map)[i] == CTRL_EMPTY) { map->growth_left--; }
+
+    set_ctrl(map, i, hash_h2(h));
+    memcpy(map_key(map, i), key, map->key_size);
+    if (map->val_size) { memcpy(map_val(map, i), val, map->val_size); }
+    map->size++;
+
+    return 1;
+}
+
+u8* hashmap_get(const HashMap* map, const u8* key)
+{
+    if (!map || !key) { return NULL; }
+
+    size_t i = map_find(map, key, map_hash(map, key));
+    if (i >= map->capacity) { return NULL; }
+
+    // sets have no value, hand back the key so the result is still usable as a bool
+    return map->val_size ? map_val(map, i) : map_key(map, i);
+}
+
+int hashmap_contains(const HashMap* map, const u8* key) {
+    return hashmap_get(map, key) != NULL;
+}
+
+int hashmap_remove(HashMap* map, const u8* key)
+{
+    if (GENVEC_UNLIKELY(!map || !key)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "hashmap remove: invalid parameters");
+        return 0;
+    }
+
+    size_t i = map_find(map, key, map_hash(map, key));
+    if (i >= map->capacity) { return 0; }
+
+    if (map->key_del) { map->key_del(map_key(map, i)); }
+    if (map->val_del) { map->val_del(map_val(map, i)); }
+
+    // tombstone keeps probe chains through this slot intact
+    set_ctrl(map, i, CTRL_DELETED);
+    map->size--;
+
+    return 1;
+}
+
+int hashmap_next(const HashMap* map, size_t* it, u8** key, u8** val)
+{
+    if (!map || !it) { return 0; }
+
+    for (size_t i = *it; i < map->capacity; i++) {
+        if (map_ctrl(map)[i] & 0x80) { continue; }
+
+        if (key) { *key = map_key(map, i); }
+        if (val) { *val = map_val(map, i); }
+        *it = i + 1;
+        return 1;
+    }
+
+    *it = map->capacity;
+    return 0;
+}
+
+uint64_t hashmap_string_hash(const u8* key, size_t key_size) {
+    (void)key_size;
+    return string_hash(*(String* const*)key);
+}
+
+int hashmap_string_eq(const u8* a, const u8* b, size_t key_size) {
+    (void)key_size;
+    return string_equals(*(String* const*)a, *(String* const*)b);
+}
@@ -0,0 +1,266 @@
+#define _GNU_SOURCE     // mremap
+
+#include "mmap_vector.h"
+#include "genvec_diag.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+static const char mmapvec_magic[8] = { 'G', 'E', 'N', 'V', 'E', 'C', '\0', '\0' };
+
+// on disk header, padded out to MMAPVEC_HEADER
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t data_size;
+    uint64_t size;
+    uint64_t capacity;
+} mmapvec_header;
+
+// every remap is a syscall and a file resize, grow in big steps and never shrink
+static const genVec_policy mmapvec_policy = {
+    .growth = 2.0,
+    .min_capacity = 1024,
+    .shrink = 0,
+    .shrink_at = 0.25,
+    .shrink_by = 0.5,
+};
+
+//private functions
+static void* mmapvec_vt_alloc(void* ctx, size_t size);
+static void* mmapvec_vt_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size);
+static void mmapvec_vt_free(void* ctx, void* ptr, size_t size);
+
+
+static inline mmapvec_header* mmapvec_hdr(const mmapVec* mv) {
+    return (mmapvec_header*)mv->map;
+}
+
+// resize the file to hold bytes of elms and remap it
+static int mmapvec_resize(mmapVec* mv, size_t bytes)
+{
+    size_t new_size = MMAPVEC_HEADER + bytes;
+    if (new_size == mv->map_size) { return 0; }
+
+    if (ftruncate(mv->fd, (off_t)new_size) != 0) { return -1; }
+
+#ifdef __linux__
+    // on failure the old mapping is still there
+    void* map = mremap(mv->map, mv->map_size, new_size, MREMAP_MAYMOVE);
+    if (map == MAP_FAILED) { return -1; }
+#else
+    munmap(mv->map, mv->map_size);
+    void* map = mmap(NULL, new_size, mv->map_prot, mv->map_flags, mv->fd, 0);
+    if (map == MAP_FAILED) {
+        mv->map = NULL;
+        return -1;
+    }
+#endif
+
+    mv->map = map;
+    mv->map_size = new_size;
+    mmapvec_hdr(mv)->capacity = bytes / mv->vec.data_size;
+    return 0;
+}
+
+static void mmapvec_write_header(mmapVec* mv)
+{
+    mmapvec_header* h = mmapvec_hdr(mv);
+    h->size = mv->vec.size;
+    h->capacity = mv->vec.capacity;
+}
+
+static int mmapvec_check_header(const mmapVec* mv, size_t data_size)
+{
+    if (mv->map_size < MMAPVEC_HEADER) { return -1; }
+
+    const mmapvec_header* h = mmapvec_hdr(mv);
+    if (memcmp(h->magic, mmapvec_magic, sizeof(mmapvec_magic)) != 0) { return -1; }
+    if (h->version != MMAPVEC_VERSION || h->header_size != MMAPVEC_HEADER) { return -1; }
+    if (h->data_size == 0 || (data_size && h->data_size != data_size)) { return -1; }
+    if (h->size > h->capacity) { return -1; }
+    if (h->capacity > (mv->map_size - MMAPVEC_HEADER) / h->data_size) { return -1; }
+
+    return 0;
+}
+
+
+mmapVec* mmapVec_open(const char* path, size_t data_size, int flags)
+{
+    if (GENVEC_UNLIKELY(!path)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "mmapVec open: path is null");
+        return NULL;
+    }
+
+    int rdwr = (flags & MMAPVEC_RDWR) != 0;
+
+    mmapVec* mv = calloc(1, sizeof(mmapVec));
+    if (GENVEC_UNLIKELY(!mv)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "mmapVec open: malloc failed");
+        return NULL;
+    }
+
+    mv->flags = flags;
+    mv->fd = open(path, rdwr ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (GENVEC_UNLIKELY(mv->fd < 0)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "mmapVec open: can't open file");
+        free(mv);
+        return NULL;
+    }
+
+    struct stat st;
+    if (GENVEC_UNLIKELY(fstat(mv->fd, &st) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "mmapVec open: fstat failed");
+        goto fail_fd;
+    }
+
+    // a fresh (or truncated) file gets an empty header
+    int fresh = rdwr && (st.st_size == 0 || (flags & MMAPVEC_TRUNC));
+    if (fresh) {
+        if (GENVEC_UNLIKELY(data_size == 0)) {
+            GENVEC_FAIL(GENVEC_ERR_INVALID, "mmapVec open: new file needs a data_size");
+            goto fail_fd;
+        }
+        if (GENVEC_UNLIKELY(ftruncate(mv->fd, 0) != 0 || ftruncate(mv->fd, MMAPVEC_HEADER) != 0)) {
+            GENVEC_FAIL(GENVEC_ERR_IO, "mmapVec open: ftruncate failed");
+            goto fail_fd;
+        }
+        st.st_size = MMAPVEC_HEADER;
+    }
+
+    mv->map_size = (size_t)st.st_size;
+    if (GENVEC_UNLIKELY(mv->map_size < MMAPVEC_HEADER)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "mmapVec open: not a genVec file");
+        goto fail_fd;
+    }
+
+    // read only maps private and writable: in place edits through the genVec API
+    // can't fault, and they never reach the file
+    mv->map_prot = PROT_READ | PROT_WRITE;
+    mv->map_flags = rdwr ? MAP_SHARED : MAP_PRIVATE;
+    mv->map = mmap(NULL, mv->map_size, mv->map_prot, mv->map_flags, mv->fd, 0);
+    if (GENVEC_UNLIKELY(mv->map == MAP_FAILED)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "mmapVec open: mmap failed");
+        goto fail_fd;
+    }
+
+    if (fresh) {
+        mmapvec_header* h = mmapvec_hdr(mv);
+        memcpy(h->magic, mmapvec_magic, sizeof(mmapvec_magic));
+        h->version = MMAPVEC_VERSION;
+        h->header_size = MMAPVEC_HEADER;
+        h->data_size = data_size;
+        h->size = 0;
+        h->capacity = 0;
+    }
+    else if (GENVEC_UNLIKELY(mmapvec_check_header(mv, data_size) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "mmapVec open: bad header or data_size mismatch");
+        goto fail_map;
+    }
+
+    const mmapvec_header* h = mmapvec_hdr(mv);
+
+    mv->allocator.alloc = mmapvec_vt_alloc;
+    mv->allocator.realloc = mmapvec_vt_realloc;
+    mv->allocator.free = mmapvec_vt_free;
+    mv->allocator.ctx = mv;
+
+    // a plain genVec over the mapping: the allocator is what grows the file
+    genVec_init_inplace(&mv->vec, 0, (size_t)h->data_size, NULL);
+    mv->vec.alloc = &mv->allocator;
+    mv->vec.policy = &mmapvec_policy;
+    mv->vec.size = (size_t)h->size;
+    mv->vec.capacity = (size_t)h->capacity;
+    mv->vec.data = h->capacity ? mv->map + MMAPVEC_HEADER : NULL;
+    mv->vec.flags = GENVEC_MAPPED;
+
+    // read only: no spare room to write into, and genVec must never hand
+    // the mapping to the allocator
+    if (!rdwr) {
+        mv->vec.capacity = mv->vec.size;
+        mv->vec.data = mv->vec.size ? mv->vec.data : NULL;
+        mv->vec.flags = GENVEC_EXTERNAL | GENVEC_MAPPED | GENVEC_FIXED;
+    }
+
+    return mv;
+
+fail_map:
+    munmap(mv->map, mv->map_size);
+fail_fd:
+    close(mv->fd);
+    free(mv);
+    return NULL;
+}
+
+void mmapVec_close(mmapVec* mv)
+{
+    if (!mv) { return; }
+
+    if (mv->map) {
+        if (mv->flags & MMAPVEC_RDWR) { mmapvec_write_header(mv); }
+        munmap(mv->map, mv->map_size);
+    }
+    close(mv->fd);
+    free(mv);
+}
+
+int mmapVec_sync(mmapVec* mv)
+{
+    if (GENVEC_UNLIKELY(!mv || !mv->map)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "mmapVec sync: mv is null or unmapped");
+        return -1;
+    }
+    if (!(mv->flags & MMAPVEC_RDWR)) { return 0; }
+
+    mmapvec_write_header(mv);
+    if (GENVEC_UNLIKELY(msync(mv->map, mv->map_size, MS_SYNC) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "mmapVec sync: msync failed");
+        return -1;
+    }
+    return 0;
+}
+
+
+// allocator vtable, the one "block" it hands out is the elm area of the file
+
+static void* mmapvec_vt_alloc(void* ctx, size_t size)
+{
+    (void)ctx;
+    (void)size;
+
+    // growth always goes through realloc (read only vecs are fixed and never get
+    // this far), any other block would get the live elm area remapped under it
+    GENVEC_FAIL(GENVEC_ERR_INVALID, "mmapVec: can't allocate new blocks from the file");
+    return NULL;
+}
+
+static void* mmapvec_vt_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size)
+{
+    (void)ptr;
+    (void)old_size;
+    mmapVec* mv = ctx;
+
+    if (GENVEC_UNLIKELY(!mv->map || mmapvec_resize(mv, new_size) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_IO, "mmapVec: growing the file failed");
+        return NULL;
+    }
+    return mv->map + MMAPVEC_HEADER;
+}
+
+static void mmapvec_vt_free(void* ctx, void* ptr, size_t size)
+{
+    (void)ptr;
+    (void)size;
+    mmapVec* mv = ctx;
+
+    // clear/shrink_to_fit on an empty vec: back down to just the header
+    if (mv->map && mmapvec_resize(mv, 0) == 0) { return; }
+    GENVEC_FAIL(GENVEC_ERR_IO, "mmapVec: truncating the file failed");
+}
@@ -0,0 +1,332 @@
+#include "ring_buffer.h"
+#include "genvec_diag.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Private helpers
+
+// largest power of two a size_t holds, anything above would overflow the rounding
+#define RING_MAX_CAPACITY ((SIZE_MAX >> 1) + 1)
+
+static size_t ring_round_capacity(size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) { cap <<= 1; }
+    return cap;
+}
+
+// capacity rounds up without overflowing, and the rounded slots fit in a size_t
+static int ring_size_ok(size_t capacity, size_t data_size) {
+    return capacity <= RING_MAX_CAPACITY && ring_round_capacity(capacity) <= SIZE_MAX / data_size;
+}
+
+// capacity slots of data_size, size == capacity so genVec_at works on every slot
+static int ring_storage(genVec* buffer, size_t cap, size_t data_size)
+{
+    if (genVec_init_inplace(buffer, cap, data_size, NULL) != 0) { return -1; }
+    buffer->size = cap;
+    return 0;
+}
+
+// copy k elms from src into the slots starting at pos, wrapping at the end
+static void ring_copy_in(genVec* buffer, size_t mask, size_t pos, const u8* src, size_t k)
+{
+    size_t sz = buffer->data_size;
+    size_t i = pos & mask;
+    size_t first = mask + 1 - i < k ? mask + 1 - i : k;
+
+    memcpy(buffer->data + (i * sz), src, first * sz);
+    memcpy(buffer->data, src + (first * sz), (k - first) * sz);
+}
+
+// copy k elms out of the slots starting at pos (out NULL runs del_fn on them instead)
+static void ring_copy_out(genVec* buffer, size_t mask, size_t pos, u8* out, size_t k, genVec_delete_fn del_fn)
+{
+    size_t sz = buffer->data_size;
+
+    if (!out) {
+        if (del_fn) {
+            for (size_t j = 0; j < k; j++) { del_fn(buffer->data + (((pos + j) & mask) * sz)); }
+        }
+        return;
+    }
+
+    size_t i = pos & mask;
+    size_t first = mask + 1 - i < k ? mask + 1 - i : k;
+
+    memcpy(out, buffer->data + (i * sz), first * sz);
+    memcpy(out + (first * sz), buffer->data, (k - first) * sz);
+}
+
+static inline size_t* seq_at(const mpmcRing* ring, size_t pos) {
+    return (size_t*)ring->seq.data + (pos & ring->mask);
+}
+
+
+// SPSC: each index has one writer, the other side only reads it.
+// Both sides cache the other's index and only reload it when they seem to run out.
+
+spscRing* spscRing_create(size_t capacity, size_t data_size, genVec_delete_fn del_fn)
+{
+    if (GENVEC_UNLIKELY(capacity == 0 || data_size == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "spscRing create: capacity and data_size can't be 0");
+        return NULL;
+    }
+    if (GENVEC_UNLIKELY(!ring_size_ok(capacity, data_size))) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "spscRing create: capacity too big");
+        return NULL;
+    }
+
+    spscRing* ring = calloc(1, sizeof(spscRing));
+    if (GENVEC_UNLIKELY(!ring)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "spscRing create: malloc failed");
+        return NULL;
+    }
+
+    size_t cap = ring_round_capacity(capacity);
+    if (ring_storage(&ring->buffer, cap, data_size) != 0) {
+        free(ring);
+        return NULL;
+    }
+
+    ring->mask = cap - 1;
+    ring->del_fn = del_fn;
+    return ring;
+}
+
+void spscRing_destroy(spscRing* ring)
+{
+    if (!ring) { return; }
+
+    ring_copy_out(&ring->buffer, ring->mask, ring->head, NULL, ring->tail - ring->head, ring->del_fn);
+    genVec_deinit(&ring->buffer);
+    free(ring);
+}
+
+size_t spscRing_push_n(spscRing* ring, const u8* data, size_t n)
+{
+    if (GENVEC_UNLIKELY(!ring || (!data && n > 0))) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "spscRing push: invalid parameters");
+        return 0;
+    }
+
+    size_t tail = ring->tail;
+    size_t cap = ring->mask + 1;
+
+    size_t free_slots = cap - (tail - ring->head_cache);
+    if (free_slots < n) {
+        ring->head_cache = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        free_slots = cap - (tail - ring->head_cache);
+    }
+
+    size_t k = n < free_slots ? n : free_slots;
+    if (k == 0) { return 0; }
+
+    ring_copy_in(&ring->buffer, ring->mask, tail, data, k);
+
+    // publish all k at once
+    __atomic_store_n(&ring->tail, tail + k, __ATOMIC_RELEASE);
+    return k;
+}
+
+size_t spscRing_pop_n(spscRing* ring, u8* out, size_t n)
+{
+    if (GENVEC_UNLIKELY(!ring)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "spscRing pop: ring is null");
+        return 0;
+    }
+
+    size_t head = ring->head;
+
+    size_t avail = ring->tail_cache - head;
+    if (avail < n) {
+        ring->tail_cache = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        avail = ring->tail_cache - head;
+    }
+
+    size_t k = n < avail ? n : avail;
+    if (k == 0) { return 0; }
+
+    ring_copy_out(&ring->buffer, ring->mask, head, out, k, ring->del_fn);
+
+    // hand the slots back to the producer
+    __atomic_store_n(&ring->head, head + k, __ATOMIC_RELEASE);
+    return k;
+}
+
+int spscRing_push(spscRing* ring, const u8* data) {
+    if (GENVEC_UNLIKELY(!data)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "spscRing push: data is null");
+        return -1;
+    }
+    return spscRing_push_n(ring, data, 1) == 1 ? 0 : -1;
+}
+
+int spscRing_pop(spscRing* ring, u8* out) {
+    return spscRing_pop_n(ring, out, 1) == 1 ? 0 : -1;
+}
+
+size_t spscRing_size(const spscRing* ring) {
+    if (!ring) { return 0; }
+    return __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+}
+
+
+// MPMC: slot s of position pos has seq == pos while free for that write and
+// pos + 1 once written. Threads claim a run of positions with one CAS on
+// head/tail after checking every slot in the run is ready, nobody else can
+// touch those slots until the index moves past them.
+
+mpmcRing* mpmcRing_create(size_t capacity, size_t data_size, genVec_delete_fn del_fn)
+{
+    if (GENVEC_UNLIKELY(capacity == 0 || data_size == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "mpmcRing create: capacity and data_size can't be 0");
+        return NULL;
+    }
+    // the sequence array needs size_t slots as well
+    if (GENVEC_UNLIKELY(!ring_size_ok(capacity, data_size > sizeof(size_t) ? data_size : sizeof(size_t)))) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "mpmcRing create: capacity too big");
+        return NULL;
+    }
+
+    mpmcRing* ring = calloc(1, sizeof(mpmcRing));
+    if (GENVEC_UNLIKELY(!ring)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "mpmcRing create: malloc failed");
+        return NULL;
+    }
+
+    size_t cap = ring_round_capacity(capacity);
+    if (ring_storage(&ring->buffer, cap, data_size) != 0) {
+        free(ring);
+        return NULL;
+    }
+    if (ring_storage(&ring->seq, cap, sizeof(size_t)) != 0) {
+        genVec_deinit(&ring->buffer);
+        free(ring);
+        return NULL;
+    }
+
+    ring->mask = cap - 1;
+    ring->del_fn = del_fn;
+    for (size_t i = 0; i < cap; i++) { *seq_at(ring, i) = i; }
+
+    return ring;
+}
+
+void mpmcRing_destroy(mpmcRing* ring)
+{
+    if (!ring) { return; }
+
+    if (ring->del_fn) {
+        for (size_t pos = ring->head; pos != ring->tail; pos++) {
+            if (*seq_at(ring, pos) == pos + 1) {
+                ring->del_fn(genVec_at(&ring->buffer, pos & ring->mask));
+            }
+        }
+    }
+    genVec_deinit(&ring->buffer);
+    genVec_deinit(&ring->seq);
+    free(ring);
+}
+
+size_t mpmcRing_push_n(mpmcRing* ring, const u8* data, size_t n)
+{
+    if (GENVEC_UNLIKELY(!ring || (!data && n > 0))) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "mpmcRing push: invalid parameters");
+        return 0;
+    }
+    if (n == 0) { return 0; }
+
+    size_t pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    size_t k;
+
+    for (;;) {
+        // how many slots from pos on are free for this round
+        k = 0;
+        while (k < n && __atomic_load_n(seq_at(ring, pos + k), __ATOMIC_ACQUIRE) == pos + k) { k++; }
+
+        if (k == 0) {
+            intptr_t dif = (intptr_t)__atomic_load_n(seq_at(ring, pos), __ATOMIC_ACQUIRE) - (intptr_t)pos;
+            if (dif < 0) { return 0; }     // slot still holds last round's elm: full
+
+            // another producer took pos already
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        // on failure pos is reloaded with the current tail
+        if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + k, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    ring_copy_in(&ring->buffer, ring->mask, pos, data, k);
+    for (size_t j = 0; j < k; j++) {
+        __atomic_store_n(seq_at(ring, pos + j), pos + j + 1, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+size_t mpmcRing_pop_n(mpmcRing* ring, u8* out, size_t n)
+{
+    if (GENVEC_UNLIKELY(!ring)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "mpmcRing pop: ring is null");
+        return 0;
+    }
+    if (n == 0) { return 0; }
+
+    size_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    size_t k;
+
+    for (;;) {
+        // how many slots from pos on hold a written elm
+        k = 0;
+        while (k < n && __atomic_load_n(seq_at(ring, pos + k), __ATOMIC_ACQUIRE) == pos + k + 1) { k++; }
+
+        if (k == 0) {
+            intptr_t dif = (intptr_t)__atomic_load_n(seq_at(ring, pos), __ATOMIC_ACQUIRE) - (intptr_t)(pos + 1);
+            if (dif < 0) { return 0; }     // nothing written at pos yet: empty
+
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        if (__atomic_compare_exchange_n(&ring->head, &pos, pos + k, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    ring_copy_out(&ring->buffer, ring->mask, pos, out, k, ring->del_fn);
+
+    // free the slots for the next round
+    for (size_t j = 0; j < k; j++) {
+        __atomic_store_n(seq_at(ring, pos + j), pos + j + ring->mask + 1, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+int mpmcRing_push(mpmcRing* ring, const u8* data) {
+    if (GENVEC_UNLIKELY(!data)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "mpmcRing push: data is null");
+        return -1;
+    }
+    return mpmcRing_push_n(ring, data, 1) == 1 ? 0 : -1;
+}
+
+int mpmcRing_pop(mpmcRing* ring, u8* out) {
+    return mpmcRing_pop_n(ring, out, 1) == 1 ? 0 : -1;
+}
+
+size_t mpmcRing_size(const mpmcRing* ring)
+{
+    if (!ring) { return 0; }
+
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    // the two loads aren't one snapshot, clamp what a race can produce
+    if (tail < head) { return 0; }
+    return tail - head > ring->mask + 1 ? ring->mask + 1 : tail - head;
+}
@@ -0,0 +1,260 @@
+#include "seg_vector.h"
+#include "genvec_diag.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define SEGVEC_MAX_BLOCK ((size_t)1 << 30)
+
+
+// Private helpers
+
+static inline u8** seg_blocks(const segVec* sv) {
+    return (u8**)sv->blocks.data;
+}
+
+static inline size_t seg_block_bytes(const segVec* sv) {
+    return (sv->mask + 1) * sv->data_size;
+}
+
+static int seg_add_block(segVec* sv)
+{
+    u8* block = malloc(seg_block_bytes(sv));
+    if (GENVEC_UNLIKELY(!block)) {
+        GENVEC_FAIL_QUIET(GENVEC_ERR_ALLOC);   // callers print their own message
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(genVec_push(&sv->blocks, (const u8*)&block) != 0)) {
+        free(block);
+        return -1;
+    }
+    return 0;
+}
+
+// free the blocks past the last one in use, keeping spare empty ones
+static void seg_trim(segVec* sv, size_t spare)
+{
+    size_t used = (sv->size + sv->mask) >> sv->shift;
+    while (sv->blocks.size > used + spare) {
+        u8* block = NULL;
+        genVec_pop(&sv->blocks, (u8*)&block);
+        free(block);
+    }
+}
+
+
+segVec* segVec_create(size_t data_size, size_t block_elms, genVec_delete_fn del_fn)
+{
+    if (GENVEC_UNLIKELY(data_size == 0)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "segVec create: data_size can't be 0");
+        return NULL;
+    }
+
+    if (block_elms == 0) { block_elms = SEGVEC_DEFAULT_BLOCK; }
+    if (GENVEC_UNLIKELY(block_elms > SEGVEC_MAX_BLOCK || data_size > SIZE_MAX / SEGVEC_MAX_BLOCK)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "segVec create: block too large");
+        return NULL;
+    }
+
+    size_t shift = 0;
+    while (((size_t)1 << shift) < block_elms) { shift++; }
+
+    segVec* sv = malloc(sizeof(segVec));
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "segVec create: malloc failed");
+        return NULL;
+    }
+
+    // the directory allocates on the first push
+    genVec_init_inplace(&sv->blocks, 0, sizeof(u8*), NULL);
+    sv->size = 0;
+    sv->data_size = data_size;
+    sv->shift = shift;
+    sv->mask = ((size_t)1 << shift) - 1;
+    sv->del_fn = del_fn;
+
+    return sv;
+}
+
+void segVec_destroy(segVec* sv)
+{
+    if (!sv) { return; }
+
+    segVec_clear(sv);
+    genVec_deinit(&sv->blocks);
+    free(sv);
+}
+
+int segVec_push(segVec* sv, const u8* data)
+{
+    if (GENVEC_UNLIKELY(!sv || !data)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "segVec push: sv or data is null");
+        return -1;
+    }
+
+    if (sv->size == segVec_capacity(sv) && GENVEC_UNLIKELY(seg_add_block(sv) != 0)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "segVec push: block allocation failed");
+        return -1;
+    }
+
+    size_t i = sv->size++;
+    memcpy(segVec_at_unchecked(sv, i), data, sv->data_size);
+    return 0;
+}
+
+int segVec_pop(segVec* sv, u8* popped)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "segVec pop: sv is null");
+        return -1;
+    }
+    if (sv->size == 0) {
+        GENVEC_FAIL_QUIET(GENVEC_ERR_EMPTY);
+        return -1;
+    }
+
+    u8* last = segVec_at_unchecked(sv, sv->size - 1);
+    if (popped) { memcpy(popped, last, sv->data_size); }
+    else if (sv->del_fn) { sv->del_fn(last); }
+
+    sv->size--;
+    seg_trim(sv, 1);
+    return 0;
+}
+
+int segVec_get(const segVec* sv, size_t i, u8* out)
+{
+    if (GENVEC_UNLIKELY(!sv || !out)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "segVec get: sv or out is null");
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(i >= sv->size)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "segVec get: index out of bounds");
+        return -1;
+    }
+
+    memcpy(out, segVec_at_unchecked(sv, i), sv->data_size);
+    return 0;
+}
+
+int segVec_replace(segVec* sv, size_t i, const u8* data)
+{
+    if (GENVEC_UNLIKELY(!sv || !data)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "segVec replace: sv or data is null");
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(i >= sv->size)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "segVec replace: index out of bounds");
+        return -1;
+    }
+
+    u8* elm = segVec_at_unchecked(sv, i);
+    if (sv->del_fn) { sv->del_fn(elm); }
+    memcpy(elm, data, sv->data_size);
+    return 0;
+}
+
+int segVec_remove(segVec* sv, size_t i)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "segVec remove: sv is null");
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(i >= sv->size)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "segVec remove: index out of bounds");
+        return -1;
+    }
+
+    if (sv->del_fn) { sv->del_fn(segVec_at_unchecked(sv, i)); }
+
+    // shift inside each block, then pull the next block's first elm into the last slot
+    u8** blocks = seg_blocks(sv);
+    size_t sz = sv->data_size;
+    size_t per = sv->mask + 1;
+    size_t first = i >> sv->shift;
+    size_t last = (sv->size - 1) >> sv->shift;
+
+    for (size_t b = first; b <= last; b++) {
+        size_t from = (b == first) ? (i & sv->mask) : 0;
+        size_t end = (b == last) ? ((sv->size - 1) & sv->mask) + 1 : per;
+
+        memmove(blocks[b] + (from * sz), blocks[b] + ((from + 1) * sz), (end - from - 1) * sz);
+        if (b < last) { memcpy(blocks[b] + ((per - 1) * sz), blocks[b + 1], sz); }
+    }
+
+    sv->size--;
+    seg_trim(sv, 1);
+    return 0;
+}
+
+int segVec_reserve(segVec* sv, size_t n)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "segVec reserve: sv is null");
+        return -1;
+    }
+
+    size_t needed = (n + sv->mask) >> sv->shift;
+    if (needed > sv->blocks.size && GENVEC_UNLIKELY(genVec_reserve(&sv->blocks, needed) != 0)) {
+        return -1;
+    }
+    while (sv->blocks.size < needed) {
+        if (GENVEC_UNLIKELY(seg_add_block(sv) != 0)) {
+            GENVEC_FAIL(GENVEC_ERR_ALLOC, "segVec reserve: block allocation failed");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void segVec_clear(segVec* sv)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "segVec clear: sv is null");
+        return;
+    }
+
+    if (sv->del_fn) {
+        for (size_t i = 0; i < sv->size; i++) { sv->del_fn(segVec_at_unchecked(sv, i)); }
+    }
+
+    u8** blocks = seg_blocks(sv);
+    for (size_t b = 0; b < sv->blocks.size; b++) { free(blocks[b]); }
+    genVec_clear(&sv->blocks);
+    sv->size = 0;
+}
+
+void segVec_shrink_to_fit(segVec* sv)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "segVec shrink to fit: sv is null");
+        return;
+    }
+
+    seg_trim(sv, 0);
+    genVec_shrink_to_fit(&sv->blocks);
+}
+
+genVec* segVec_to_genVec(const segVec* sv)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "segVec to genVec: sv is null");
+        return NULL;
+    }
+
+    genVec* vec = genVec_init(sv->size, sv->data_size, NULL);
+    if (!vec) { return NULL; }
+
+    // one memcpy per block
+    u8** blocks = seg_blocks(sv);
+    size_t per = sv->mask + 1;
+    for (size_t done = 0, b = 0; done < sv->size; b++) {
+        size_t k = sv->size - done < per ? sv->size - done : per;
+        memcpy(vec->data + (done * sv->data_size), blocks[b], k * sv->data_size);
+        done += k;
+    }
+    vec->size = sv->size;
+    return vec;
+}
@@ -0,0 +1,216 @@
+#include "soa_vector.h"
+#include "genvec_diag.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// Private helpers
+
+static inline u8* col_elm(const genVec* col, size_t i) {
+    return col->data + (i * col->data_size);
+}
+
+// every column shrinks by the same policy at the same size, so they stay in step
+static void soa_set_size(soaVec* sv, size_t n, int shrink)
+{
+    for (size_t f = 0; f < sv->n_fields; f++) {
+        sv->cols[f].size = n;
+        if (shrink) { genVec_auto_shrink(&sv->cols[f]); }
+    }
+}
+
+
+soaVec* soaVec_create(const soaField* fields, size_t n_fields, size_t row_size)
+{
+    if (GENVEC_UNLIKELY(!fields)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "soaVec create: fields is null");
+        return NULL;
+    }
+    if (GENVEC_UNLIKELY(n_fields == 0 || n_fields > SOAVEC_MAX_FIELDS)) {
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "soaVec create: 1 to SOAVEC_MAX_FIELDS fields");
+        return NULL;
+    }
+    for (size_t f = 0; f < n_fields; f++) {
+        if (GENVEC_UNLIKELY(fields[f].size == 0 || fields[f].offset > row_size ||
+                            fields[f].size > row_size - fields[f].offset)) {
+            GENVEC_FAIL(GENVEC_ERR_INVALID, "soaVec create: field is empty or outside the row");
+            return NULL;
+        }
+    }
+
+    soaVec* sv = malloc(sizeof(soaVec));
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "soaVec create: malloc failed");
+        return NULL;
+    }
+
+    sv->cols = malloc(n_fields * sizeof(genVec));
+    sv->fields = malloc(n_fields * sizeof(soaField));
+    if (GENVEC_UNLIKELY(!sv->cols || !sv->fields)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "soaVec create: malloc failed");
+        free(sv->cols);
+        free(sv->fields);
+        free(sv);
+        return NULL;
+    }
+
+    memcpy(sv->fields, fields, n_fields * sizeof(soaField));
+    sv->n_fields = n_fields;
+    sv->row_size = row_size;
+
+    // empty columns, nothing is allocated until the first push or reserve
+    for (size_t f = 0; f < n_fields; f++) {
+        genVec_init_inplace(&sv->cols[f], 0, fields[f].size, NULL);
+    }
+
+    return sv;
+}
+
+void soaVec_destroy(soaVec* sv)
+{
+    if (!sv) { return; }
+
+    for (size_t f = 0; f < sv->n_fields; f++) { genVec_deinit(&sv->cols[f]); }
+    free(sv->cols);
+    free(sv->fields);
+    free(sv);
+}
+
+int soaVec_reserve(soaVec* sv, size_t n)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "soaVec reserve: sv is null");
+        return -1;
+    }
+
+    for (size_t f = 0; f < sv->n_fields; f++) {
+        if (genVec_reserve(&sv->cols[f], n) != 0) { return -1; }
+    }
+    return 0;
+}
+
+int soaVec_push(soaVec* sv, const u8* row)
+{
+    if (GENVEC_UNLIKELY(!sv || !row)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "soaVec push: sv or row is null");
+        return -1;
+    }
+
+    // room in every column first, so a failed push leaves all of them untouched
+    size_t n = soaVec_size(sv);
+    for (size_t f = 0; f < sv->n_fields; f++) {
+        if (n < sv->cols[f].capacity) { continue; }
+        if (GENVEC_UNLIKELY(genVec_ensure(&sv->cols[f], n + 1) != 0)) {
+            GENVEC_FAIL(GENVEC_ERR_ALLOC, "soaVec push: column growth failed");
+            return -1;
+        }
+    }
+
+    for (size_t f = 0; f < sv->n_fields; f++) {
+        memcpy(col_elm(&sv->cols[f], n), row + sv->fields[f].offset, sv->fields[f].size);
+    }
+    soa_set_size(sv, n + 1, 0);
+    return 0;
+}
+
+int soaVec_pop(soaVec* sv, u8* row)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "soaVec pop: sv is null");
+        return -1;
+    }
+
+    size_t n = soaVec_size(sv);
+    if (n == 0) {
+        GENVEC_FAIL_QUIET(GENVEC_ERR_EMPTY);
+        return -1;
+    }
+
+    if (row) { soaVec_get(sv, n - 1, row); }
+    soa_set_size(sv, n - 1, 1);
+    return 0;
+}
+
+int soaVec_get(const soaVec* sv, size_t i, u8* row)
+{
+    if (GENVEC_UNLIKELY(!sv || !row)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "soaVec get: sv or row is null");
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(i >= soaVec_size(sv))) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "soaVec get: index out of bounds");
+        return -1;
+    }
+
+    for (size_t f = 0; f < sv->n_fields; f++) {
+        memcpy(row + sv->fields[f].offset, col_elm(&sv->cols[f], i), sv->fields[f].size);
+    }
+    return 0;
+}
+
+int soaVec_set(soaVec* sv, size_t i, const u8* row)
+{
+    if (GENVEC_UNLIKELY(!sv || !row)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "soaVec set: sv or row is null");
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(i >= soaVec_size(sv))) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "soaVec set: index out of bounds");
+        return -1;
+    }
+
+    for (size_t f = 0; f < sv->n_fields; f++) {
+        memcpy(col_elm(&sv->cols[f], i), row + sv->fields[f].offset, sv->fields[f].size);
+    }
+    return 0;
+}
+
+int soaVec_remove(soaVec* sv, size_t i)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "soaVec remove: sv is null");
+        return -1;
+    }
+    if (GENVEC_UNLIKELY(i >= soaVec_size(sv))) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "soaVec remove: index out of bounds");
+        return -1;
+    }
+
+    // can't fail once the index is checked, so the columns never drift apart
+    for (size_t f = 0; f < sv->n_fields; f++) { genVec_remove(&sv->cols[f], i); }
+    return 0;
+}
+
+int soaVec_swap_remove(soaVec* sv, size_t i)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "soaVec swap remove: sv is null");
+        return -1;
+    }
+
+    size_t n = soaVec_size(sv);
+    if (GENVEC_UNLIKELY(i >= n)) {
+        GENVEC_FAIL(GENVEC_ERR_BOUNDS, "soaVec swap remove: index out of bounds");
+        return -1;
+    }
+
+    if (i != n - 1) {
+        for (size_t f = 0; f < sv->n_fields; f++) {
+            genVec* col = &sv->cols[f];
+            memcpy(col_elm(col, i), col_elm(col, n - 1), col->data_size);
+        }
+    }
+    soa_set_size(sv, n - 1, 1);
+    return 0;
+}
+
+void soaVec_clear(soaVec* sv)
+{
+    if (GENVEC_UNLIKELY(!sv)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "soaVec clear: sv is null");
+        return;
+    }
+
+    for (size_t f = 0; f < sv->n_fields; f++) { genVec_clear(&sv->cols[f]); }
+}
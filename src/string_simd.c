@@ -0,0 +1,629 @@
+#include "string_simd.h"
+
+#include <stdint.h>
+#include <string.h>
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__SSE2__))
+    #define STR_SIMD_SSE2 1
+    #define STR_SIMD_AVX2 1
+    #include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+    #define STR_SIMD_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__)
+    #define LOAD_FN(p) __atomic_load_n(&(p), __ATOMIC_RELAXED)
+    #define STORE_FN(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELAXED)
+#else
+    #define LOAD_FN(p) (p)
+    #define STORE_FN(p, v) ((p) = (v))
+#endif
+
+
+typedef size_t (*find_char_fn)(const char* s, size_t len, char c);
+typedef size_t (*find_fn)(const char* hay, size_t hay_len, const char* needle, size_t needle_len);
+typedef int (*equal_fn)(const char* a, const char* b, size_t n);
+typedef int (*utf8_check_fn)(const char* s, size_t len);
+typedef size_t (*utf8_count_fn)(const char* s, size_t len);
+
+//private functions
+static size_t find_char_resolve(const char* s, size_t len, char c);
+static size_t find_resolve(const char* hay, size_t hay_len, const char* needle, size_t needle_len);
+static int equal_resolve(const char* a, const char* b, size_t n);
+static int utf8_check_resolve(const char* s, size_t len);
+static size_t utf8_count_resolve(const char* s, size_t len);
+
+// start out on the resolvers, which swap in the best kernel on first use
+static find_char_fn find_char_impl = find_char_resolve;
+static find_fn find_impl = find_resolve;
+static equal_fn equal_impl = equal_resolve;
+static utf8_check_fn utf8_check_impl = utf8_check_resolve;
+static utf8_count_fn utf8_count_impl = utf8_count_resolve;
+
+
+// check the remaining start positions from i on, one at a time
+static size_t find_tail(const char* hay, size_t hay_len, const char* needle, size_t needle_len, size_t i)
+{
+    for (; i + needle_len <= hay_len; i++) {
+        if (hay[i] == needle[0] && memcmp(hay + i, needle, needle_len) == 0) { return i; }
+    }
+    return STR_NPOS;
+}
+
+// Unicode table 3-7: no overlongs, no surrogates, nothing past U+10FFFF
+size_t str_utf8_decode(const char* s, size_t len, uint32_t* cp)
+{
+    const unsigned char* u = (const unsigned char*)s;
+    if (len == 0) { return 0; }
+
+    unsigned c = u[0];
+    if (c < 0x80) {
+        if (cp) { *cp = c; }
+        return 1;
+    }
+
+    // the lead byte sets the length and the allowed range of the second byte
+    size_t n;
+    uint32_t v;
+    unsigned lo = 0x80, hi = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF)      { n = 2; v = c & 0x1F; }
+    else if (c >= 0xE0 && c <= 0xEF) { n = 3; v = c & 0x0F; if (c == 0xE0) { lo = 0xA0; } if (c == 0xED) { hi = 0x9F; } }
+    else if (c >= 0xF0 && c <= 0xF4) { n = 4; v = c & 0x07; if (c == 0xF0) { lo = 0x90; } if (c == 0xF4) { hi = 0x8F; } }
+    else { return 0; }   // continuation byte, C0/C1 (always overlong) or past F4
+
+    if (len < n || u[1] < lo || u[1] > hi) { return 0; }
+    v = (v << 6) | (u[1] & 0x3Fu);
+    for (size_t k = 2; k < n; k++) {
+        if ((u[k] & 0xC0u) != 0x80u) { return 0; }
+        v = (v << 6) | (u[k] & 0x3Fu);
+    }
+
+    if (cp) { *cp = v; }
+    return n;
+}
+
+// char by char from i on, for whatever the block loops leave over
+static int utf8_check_tail(const char* s, size_t len, size_t i, int ascii)
+{
+    while (i < len) {
+        size_t n = str_utf8_decode(s + i, len - i, NULL);
+        if (n == 0) { return STR_UTF8_INVALID; }
+        if (n > 1) { ascii = 0; }
+        i += n;
+    }
+    return ascii ? STR_UTF8_ASCII : STR_UTF8_VALID;
+}
+
+static size_t utf8_count_tail(const char* s, size_t len, size_t i, size_t count)
+{
+    for (; i < len; i++) { count += ((unsigned char)s[i] & 0xC0u) != 0x80u; }
+    return count;
+}
+
+
+#if !STR_SIMD_SSE2 && !STR_SIMD_NEON
+
+// scalar (libc) kernels
+
+static size_t find_char_scalar(const char* s, size_t len, char c) {
+    const char* found = memchr(s, c, len);
+    return found ? (size_t)(found - s) : STR_NPOS;
+}
+
+static size_t find_scalar(const char* hay, size_t hay_len, const char* needle, size_t needle_len)
+{
+    size_t i = 0;
+    while (i + needle_len <= hay_len) {
+        const char* found = memchr(hay + i, needle[0], hay_len - needle_len - i + 1);
+        if (!found) { return STR_NPOS; }
+
+        i = (size_t)(found - hay);
+        if (memcmp(hay + i + 1, needle + 1, needle_len - 1) == 0) { return i; }
+        i++;
+    }
+    return STR_NPOS;
+}
+
+static int equal_scalar(const char* a, const char* b, size_t n) {
+    return memcmp(a, b, n) == 0;
+}
+
+// ascii runs 8 bytes at a time, then one character
+static int utf8_check_scalar(const char* s, size_t len)
+{
+    int ascii = 1;
+    size_t i = 0;
+    while (i + 8 <= len) {
+        uint64_t w;
+        memcpy(&w, s + i, sizeof(w));
+        if (!(w & 0x8080808080808080ull)) { i += 8; continue; }
+
+        size_t n = str_utf8_decode(s + i, len - i, NULL);
+        if (n == 0) { return STR_UTF8_INVALID; }
+        if (n > 1) { ascii = 0; }
+        i += n;
+    }
+    return utf8_check_tail(s, len, i, ascii);
+}
+
+static size_t utf8_count_scalar(const char* s, size_t len) {
+    return utf8_count_tail(s, len, 0, 0);
+}
+
+#endif
+
+
+#if STR_SIMD_SSE2
+
+static size_t find_char_sse2(const char* s, size_t len, char c)
+{
+    const __m128i v = _mm_set1_epi8(c);
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(s + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, v));
+        if (mask) { return i + (size_t)__builtin_ctz(mask); }
+    }
+    for (; i < len; i++) {
+        if (s[i] == c) { return i; }
+    }
+    return STR_NPOS;
+}
+
+// first/last byte filter: only positions where both the first and last
+// needle bytes match get a full memcmp
+static size_t find_sse2(const char* hay, size_t hay_len, const char* needle, size_t needle_len)
+{
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needle_len - 1]);
+
+    size_t i = 0;
+    for (; i + needle_len + 15 <= hay_len; i += 16) {
+        __m128i block_first = _mm_loadu_si128((const __m128i*)(hay + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i*)(hay + i + needle_len - 1));
+
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, needle_len - 2) == 0) { return i + bit; }
+            mask &= mask - 1;
+        }
+    }
+    return find_tail(hay, hay_len, needle, needle_len, i);
+}
+
+static int equal_sse2(const char* a, const char* b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF) { return 0; }
+    }
+    return memcmp(a + i, b + i, n - i) == 0;
+}
+
+// skips ascii 16 bytes at a time, then checks the character at the first high byte
+static int utf8_check_sse2(const char* s, size_t len)
+{
+    int ascii = 1;
+    size_t i = 0;
+    while (i + 16 <= len) {
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(s + i)));
+        if (!mask) { i += 16; continue; }
+
+        i += (size_t)__builtin_ctz(mask);
+        size_t n = str_utf8_decode(s + i, len - i, NULL);
+        if (n == 0) { return STR_UTF8_INVALID; }
+        ascii = 0;
+        i += n;
+    }
+    return utf8_check_tail(s, len, i, ascii);
+}
+
+// continuation bytes are -128..-65 as int8, everything greater starts a character
+static size_t utf8_count_sse2(const char* s, size_t len)
+{
+    const __m128i cont_max = _mm_set1_epi8(-65);
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i lead = _mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)(s + i)), cont_max);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_and_si128(lead, one), zero));
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    return utf8_count_tail(s, len, i, (size_t)(lanes[0] + lanes[1]));
+}
+
+#endif
+
+
+#if STR_SIMD_AVX2
+
+__attribute__((target("avx2")))
+static size_t find_char_avx2(const char* s, size_t len, char c)
+{
+    const __m256i v = _mm256_set1_epi8(c);
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(s + i));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, v));
+        if (mask) { return i + (size_t)__builtin_ctz(mask); }
+    }
+
+    size_t rest = find_char_sse2(s + i, len - i, c);
+    return rest == STR_NPOS ? STR_NPOS : i + rest;
+}
+
+__attribute__((target("avx2")))
+static size_t find_avx2(const char* hay, size_t hay_len, const char* needle, size_t needle_len)
+{
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[needle_len - 1]);
+
+    size_t i = 0;
+    for (; i + needle_len + 31 <= hay_len; i += 32) {
+        __m256i block_first = _mm256_loadu_si256((const __m256i*)(hay + i));
+        __m256i block_last = _mm256_loadu_si256((const __m256i*)(hay + i + needle_len - 1));
+
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last)));
+
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, needle_len - 2) == 0) { return i + bit; }
+            mask &= mask - 1;
+        }
+    }
+    return find_tail(hay, hay_len, needle, needle_len, i);
+}
+
+__attribute__((target("avx2")))
+static int equal_avx2(const char* a, const char* b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        if ((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)) != 0xFFFFFFFFu) { return 0; }
+    }
+    return equal_sse2(a + i, b + i, n - i);
+}
+
+// Keiser and Lemire's lookup validation (the simdjson/simdutf one): three nibble
+// lookups on each byte and the one before it flag every bad 2 byte pattern, and the
+// bytes 2 and 3 after a 3/4 byte lead must be the continuations nothing else claimed
+#define UTF8_TOO_SHORT  0x01    // lead (or ascii) where a continuation should be
+#define UTF8_TOO_LONG   0x02    // ascii followed by a continuation
+#define UTF8_OVERLONG_3 0x04
+#define UTF8_TOO_LARGE  0x08    // past U+10FFFF
+#define UTF8_SURROGATE  0x10
+#define UTF8_OVERLONG_2 0x20
+#define UTF8_TOO_LARGE_1000 0x40
+#define UTF8_OVERLONG_4 0x40
+#define UTF8_TWO_CONTS  0x80    // continuation after a continuation (fine for 3/4 byte chars)
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+// nibble tables, indexed by the high/low half of the byte before and of the byte itself
+static const uint8_t utf8_byte_1_high[16] = {
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+};
+static const uint8_t utf8_byte_1_low[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+};
+static const uint8_t utf8_byte_2_high[16] = {
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+
+// the 32 bytes ending n bytes before the end of input
+#define UTF8_PREV_AVX2(input, prev, n) \
+    _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev), (input), 0x21), 16 - (n))
+
+// a 16 entry table in both lanes, pshufb looks up within each 128 bit lane
+__attribute__((target("avx2")))
+static inline __m256i utf8_table_avx2(const uint8_t table[16]) {
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)table));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i utf8_errors_avx2(__m256i input, __m256i prev_input)
+{
+    const __m256i byte_1_high = utf8_table_avx2(utf8_byte_1_high);
+    const __m256i byte_1_low = utf8_table_avx2(utf8_byte_1_low);
+    const __m256i byte_2_high = utf8_table_avx2(utf8_byte_2_high);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+
+    __m256i prev1 = UTF8_PREV_AVX2(input, prev_input, 1);
+    __m256i special = _mm256_and_si256(
+        _mm256_and_si256(_mm256_shuffle_epi8(byte_1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low)),
+                         _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, low))),
+        _mm256_shuffle_epi8(byte_2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), low)));
+
+    // only 111_____ two back and 1111____ three back land >= 0x80 here
+    __m256i third = _mm256_subs_epu8(UTF8_PREV_AVX2(input, prev_input, 2), _mm256_set1_epi8((char)(0xe0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(UTF8_PREV_AVX2(input, prev_input, 3), _mm256_set1_epi8((char)(0xf0 - 0x80)));
+    __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+
+    return _mm256_xor_si256(must23, special);
+}
+
+__attribute__((target("avx2")))
+static int utf8_check_avx2(const char* s, size_t len)
+{
+    // a lead in the last 3 bytes of a block needs continuations in the next one
+    const __m256i max_complete = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xf0 - 1), (char)(0xe0 - 1), (char)(0xc0 - 1));
+
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    unsigned high = 0;
+
+    // the last partial block is zero padded, zeros are ascii so a cut off character is too short
+    unsigned char tail[32];
+    size_t i = 0;
+    for (;;) {
+        __m256i input;
+        int last = i + 32 > len;
+        if (!last) {
+            input = _mm256_loadu_si256((const __m256i*)(s + i));
+        } else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, len - i);
+            input = _mm256_loadu_si256((const __m256i*)tail);
+        }
+
+        unsigned mask = (unsigned)_mm256_movemask_epi8(input);
+        if (!mask) {
+            error = _mm256_or_si256(error, prev_incomplete);
+        } else {
+            high = 1;
+            error = _mm256_or_si256(error, utf8_errors_avx2(input, prev_input));
+            prev_incomplete = _mm256_subs_epu8(input, max_complete);
+        }
+        prev_input = input;
+
+        if (last) { break; }
+        i += 32;
+    }
+    error = _mm256_or_si256(error, prev_incomplete);
+
+    if (!_mm256_testz_si256(error, error)) { return STR_UTF8_INVALID; }
+    return high ? STR_UTF8_VALID : STR_UTF8_ASCII;
+}
+
+__attribute__((target("avx2")))
+static size_t utf8_count_avx2(const char* s, size_t len)
+{
+    const __m256i cont_max = _mm256_set1_epi8(-65);
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i lead = _mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)(s + i)), cont_max);
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_and_si256(lead, one), zero));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    return utf8_count_tail(s, len, i, (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]));
+}
+
+#endif
+
+
+#if STR_SIMD_NEON
+
+// 4 bits per byte lane, so the lane index is ctz / 4
+static inline uint64_t neon_mask(uint8x16_t eq) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+}
+
+static size_t find_char_neon(const char* s, size_t len, char c)
+{
+    const uint8x16_t v = vdupq_n_u8((uint8_t)c);
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint64_t mask = neon_mask(vceqq_u8(vld1q_u8((const uint8_t*)s + i), v));
+        if (mask) { return i + ((size_t)__builtin_ctzll(mask) >> 2); }
+    }
+    for (; i < len; i++) {
+        if (s[i] == c) { return i; }
+    }
+    return STR_NPOS;
+}
+
+static size_t find_neon(const char* hay, size_t hay_len, const char* needle, size_t needle_len)
+{
+    const uint8x16_t first = vdupq_n_u8((uint8_t)needle[0]);
+    const uint8x16_t last = vdupq_n_u8((uint8_t)needle[needle_len - 1]);
+
+    size_t i = 0;
+    for (; i + needle_len + 15 <= hay_len; i += 16) {
+        uint8x16_t block_first = vld1q_u8((const uint8_t*)hay + i);
+        uint8x16_t block_last = vld1q_u8((const uint8_t*)hay + i + needle_len - 1);
+
+        uint64_t mask = neon_mask(vandq_u8(vceqq_u8(first, block_first), vceqq_u8(last, block_last)));
+
+        while (mask) {
+            size_t bit = (size_t)__builtin_ctzll(mask) >> 2;
+            if (memcmp(hay + i + bit + 1, needle + 1, needle_len - 2) == 0) { return i + bit; }
+            mask &= ~(0xFull << (bit << 2));
+        }
+    }
+    return find_tail(hay, hay_len, needle, needle_len, i);
+}
+
+static int equal_neon(const char* a, const char* b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8((const uint8_t*)a + i), vld1q_u8((const uint8_t*)b + i));
+        if (vminvq_u8(eq) != 0xFF) { return 0; }
+    }
+    return memcmp(a + i, b + i, n - i) == 0;
+}
+
+static int utf8_check_neon(const char* s, size_t len)
+{
+    const uint8x16_t high = vdupq_n_u8(0x80);
+
+    int ascii = 1;
+    size_t i = 0;
+    while (i + 16 <= len) {
+        uint64_t mask = neon_mask(vcgeq_u8(vld1q_u8((const uint8_t*)s + i), high));
+        if (!mask) { i += 16; continue; }
+
+        i += (size_t)__builtin_ctzll(mask) >> 2;
+        size_t n = str_utf8_decode(s + i, len - i, NULL);
+        if (n == 0) { return STR_UTF8_INVALID; }
+        ascii = 0;
+        i += n;
+    }
+    return utf8_check_tail(s, len, i, ascii);
+}
+
+static size_t utf8_count_neon(const char* s, size_t len)
+{
+    const int8x16_t cont_max = vdupq_n_s8(-65);
+
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t lead = vcgtq_s8(vld1q_s8((const int8_t*)s + i), cont_max);
+        count += vaddvq_u8(vshrq_n_u8(lead, 7));
+    }
+    return utf8_count_tail(s, len, i, count);
+}
+
+#endif
+
+
+// pick the kernels for this cpu, every thread picks the same ones so racing is harmless
+static void str_simd_resolve(void)
+{
+#if STR_SIMD_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        STORE_FN(find_char_impl, find_char_avx2);
+        STORE_FN(find_impl, find_avx2);
+        STORE_FN(equal_impl, equal_avx2);
+        STORE_FN(utf8_check_impl, utf8_check_avx2);
+        STORE_FN(utf8_count_impl, utf8_count_avx2);
+        return;
+    }
+#endif
+#if STR_SIMD_SSE2
+    STORE_FN(find_char_impl, find_char_sse2);
+    STORE_FN(find_impl, find_sse2);
+    STORE_FN(equal_impl, equal_sse2);
+    STORE_FN(utf8_check_impl, utf8_check_sse2);
+    STORE_FN(utf8_count_impl, utf8_count_sse2);
+#elif STR_SIMD_NEON
+    STORE_FN(find_char_impl, find_char_neon);
+    STORE_FN(find_impl, find_neon);
+    STORE_FN(equal_impl, equal_neon);
+    STORE_FN(utf8_check_impl, utf8_check_neon);
+    STORE_FN(utf8_count_impl, utf8_count_neon);
+#else
+    STORE_FN(find_char_impl, find_char_scalar);
+    STORE_FN(find_impl, find_scalar);
+    STORE_FN(equal_impl, equal_scalar);
+    STORE_FN(utf8_check_impl, utf8_check_scalar);
+    STORE_FN(utf8_count_impl, utf8_count_scalar);
+#endif
+}
+
+static size_t find_char_resolve(const char* s, size_t len, char c) {
+    str_simd_resolve();
+    return LOAD_FN(find_char_impl)(s, len, c);
+}
+
+static size_t find_resolve(const char* hay, size_t hay_len, const char* needle, size_t needle_len) {
+    str_simd_resolve();
+    return LOAD_FN(find_impl)(hay, hay_len, needle, needle_len);
+}
+
+static int equal_resolve(const char* a, const char* b, size_t n) {
+    str_simd_resolve();
+    return LOAD_FN(equal_impl)(a, b, n);
+}
+
+static int utf8_check_resolve(const char* s, size_t len) {
+    str_simd_resolve();
+    return LOAD_FN(utf8_check_impl)(s, len);
+}
+
+static size_t utf8_count_resolve(const char* s, size_t len) {
+    str_simd_resolve();
+    return LOAD_FN(utf8_count_impl)(s, len);
+}
+
+
+size_t str_simd_find_char(const char* s, size_t len, char c) {
+    return LOAD_FN(find_char_impl)(s, len, c);
+}
+
+size_t str_simd_find(const char* hay, size_t hay_len, const char* needle, size_t needle_len)
+{
+    if (needle_len == 0) { return 0; }
+    if (needle_len > hay_len) { return STR_NPOS; }
+    if (needle_len == 1) { return str_simd_find_char(hay, hay_len, needle[0]); }
+
+    return LOAD_FN(find_impl)(hay, hay_len, needle, needle_len);
+}
+
+int str_simd_equal(const char* a, const char* b, size_t n) {
+    return LOAD_FN(equal_impl)(a, b, n);
+}
+
+int str_simd_utf8_check(const char* s, size_t len) {
+    return LOAD_FN(utf8_check_impl)(s, len);
+}
+
+size_t str_simd_utf8_count(const char* s, size_t len) {
+    return LOAD_FN(utf8_count_impl)(s, len);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Private length aware search/compare kernels for String.c.
+// SSE2/NEON where they are baseline, AVX2 picked at runtime on x86.
+
+#define STR_NPOS ((size_t)-1)
+
+// index of the first c in s[0, len), STR_NPOS if there is none
+size_t str_simd_find_char(const char* s, size_t len, char c);
+
+// index of the first needle in hay, STR_NPOS if there is none
+size_t str_simd_find(const char* hay, size_t hay_len, const char* needle, size_t needle_len);
+
+// 1 if the n bytes at a and b are equal
+int str_simd_equal(const char* a, const char* b, size_t n);
+
+// str_simd_utf8_check results
+#define STR_UTF8_INVALID 0
+#define STR_UTF8_VALID   1      // valid, with at least one multibyte character
+#define STR_UTF8_ASCII   2      // every byte < 0x80
+
+// classify s[0, len), a character cut off at the end counts as invalid
+int str_simd_utf8_check(const char* s, size_t len);
+
+// code points in valid UTF-8 (the bytes that aren't continuation bytes)
+size_t str_simd_utf8_count(const char* s, size_t len);
+
+// length (1 to 4) of the valid character at s, 0 if it is invalid or cut off. cp may be NULL
+size_t str_utf8_decode(const char* s, size_t len, uint32_t* cp);
@@ -0,0 +1,473 @@
+#ifdef __linux__
+    #define _GNU_SOURCE     // pthread_setaffinity_np
+#endif
+
+#include "thread_pool.h"
+#include "gen_vector.h"
+#include "ring_buffer.h"
+#include "genvec_diag.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+#define TPOOL_MAX_THREADS 256
+#define TPOOL_LINE 64
+#define TPOOL_DEQUE_CAP 4096        // per worker, spawning into a full deque runs the task inline
+#define TPOOL_INJECT_CAP 1024       // spawns from threads outside the pool
+#define TPOOL_SPINS 64              // empty rounds (with a yield each) before a worker sleeps
+
+
+// Chase-Lev deque of task*: the owner pushes and pops at bottom, thieves take
+// from top. Fixed capacity, slots is a genVec with size == capacity.
+typedef struct {
+    int64_t top;                    // atomic
+    char pad0[TPOOL_LINE - sizeof(int64_t)];
+    int64_t bottom;                 // atomic
+    char pad1[TPOOL_LINE - sizeof(int64_t)];
+    genVec slots;
+    size_t mask;
+} tpool_deque;
+
+typedef struct {
+    tpool_deque deque;
+    ThreadPool* pool;
+    pthread_t thread;
+    size_t id;                      // 1.., the creating thread counts as 0
+    uint32_t rng;
+} tpool_worker;
+
+struct ThreadPool {
+    tpool_worker* workers;          // n_workers deques, the first n_started have a thread
+    size_t n_workers;
+    size_t n_started;
+    mpmcRing* inject;
+    int pinned;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;            // idle workers sleep here
+    size_t sleepers;                // atomic, spawners only signal when it is non zero
+    int stop;                       // under lock
+};
+
+// the worker this thread is, NULL outside every pool
+static __thread tpool_worker* tpool_self = NULL;
+// steal order for threads that aren't workers
+static __thread uint32_t tpool_seed = 0;
+// set while a thread that isn't a worker runs a task from inside task_wait
+static __thread int tpool_helping = 0;
+
+static ThreadPool* tpool_shared = NULL;     // atomic
+static pthread_mutex_t tpool_shared_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+// Private helpers
+
+static size_t tpool_cpus(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (size_t)cpus : 1;
+}
+
+static inline uint32_t tpool_next_rng(uint32_t* s)
+{
+    uint32_t x = *s ? *s : (uint32_t)(uintptr_t)s | 1u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+static int deque_init(tpool_deque* d)
+{
+    if (genVec_init_inplace(&d->slots, TPOOL_DEQUE_CAP, sizeof(task*), NULL) != 0) { return -1; }
+    d->slots.size = TPOOL_DEQUE_CAP;
+    d->mask = TPOOL_DEQUE_CAP - 1;
+    d->top = 0;
+    d->bottom = 0;
+    return 0;
+}
+
+static inline task** deque_slot(tpool_deque* d, int64_t i) {
+    return (task**)d->slots.data + ((size_t)i & d->mask);
+}
+
+// owner only, -1 when full
+static int deque_push(tpool_deque* d, task* t)
+{
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+    int64_t top = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    if (b - top > (int64_t)d->mask) { return -1; }
+
+    // release publishes the task's fields along with the slot
+    __atomic_store_n(deque_slot(d, b), t, __ATOMIC_RELAXED);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// owner only, newest first
+static task* deque_pop(tpool_deque* d)
+{
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+
+    if (top > b) {
+        // was empty
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    task* t = __atomic_load_n(deque_slot(d, b), __ATOMIC_RELAXED);
+    if (top == b) {
+        // last one, race the thieves for it
+        if (!__atomic_compare_exchange_n(&d->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            t = NULL;
+        }
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return t;
+}
+
+// any thread, oldest first. NULL when empty or another thief won
+static task* deque_steal(tpool_deque* d)
+{
+    int64_t top = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+    if (top >= b) { return NULL; }
+
+    task* t = __atomic_load_n(deque_slot(d, top), __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&d->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    return t;
+}
+
+static inline int deque_has_work(tpool_deque* d) {
+    return __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE) > __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+}
+
+static int tpool_has_work(ThreadPool* pool)
+{
+    if (mpmcRing_size(pool->inject) > 0) { return 1; }
+    for (size_t i = 0; i < pool->n_workers; i++) {
+        if (deque_has_work(&pool->workers[i].deque)) { return 1; }
+    }
+    return 0;
+}
+
+// own deque, then the injection queue, then one round of steals from a random start
+static task* tpool_find(ThreadPool* pool, tpool_worker* self)
+{
+    task* t = NULL;
+    if (self && (t = deque_pop(&self->deque))) { return t; }
+    if (mpmcRing_pop(pool->inject, (u8*)&t) == 0) { return t; }
+
+    size_t n = pool->n_workers;
+    if (n == 0) { return NULL; }
+    size_t start = tpool_next_rng(self ? &self->rng : &tpool_seed) % n;
+    for (size_t i = 0; i < n; i++) {
+        tpool_worker* w = &pool->workers[(start + i) % n];
+        if (w == self) { continue; }
+        if ((t = deque_steal(&w->deque))) { return t; }
+    }
+    return NULL;
+}
+
+// the group counter is the last thing touched, t may be gone right after
+static inline void tpool_run(task* t)
+{
+    taskGroup* group = t->group;
+    t->fn(t->arg);
+    __atomic_sub_fetch(&group->pending, 1, __ATOMIC_RELEASE);
+}
+
+// pairs with the sleepers bump + recheck in tpool_worker_main
+static inline void tpool_notify(ThreadPool* pool)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->sleepers, __ATOMIC_RELAXED) == 0) { return; }
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void tpool_pin(size_t id)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(id % tpool_cpus(), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);   // best effort
+#else
+    (void)id;
+#endif
+}
+
+static void* tpool_worker_main(void* arg)
+{
+    tpool_worker* self = arg;
+    ThreadPool* pool = self->pool;
+
+    tpool_self = self;
+    if (pool->pinned) { tpool_pin(self->id); }
+
+    size_t idle = 0;
+    for (;;) {
+        task* t = tpool_find(pool, self);
+        if (t) {
+            tpool_run(t);
+            idle = 0;
+            continue;
+        }
+        if (++idle < TPOOL_SPINS) {
+            sched_yield();
+            continue;
+        }
+
+        // announce ourselves, then look once more - a spawn racing us either
+        // sees sleepers or its task is seen here
+        pthread_mutex_lock(&pool->lock);
+        __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        while (!pool->stop && !tpool_has_work(pool)) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        int stop = pool->stop;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (stop) { break; }
+        idle = 0;
+    }
+    return NULL;
+}
+
+static ThreadPool* tpool_make(size_t n_threads, int pinned)
+{
+    if (n_threads == 0) { n_threads = tpool_cpus(); }
+    if (n_threads > TPOOL_MAX_THREADS) { n_threads = TPOOL_MAX_THREADS; }
+
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    if (GENVEC_UNLIKELY(!pool)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "tpool create: malloc failed");
+        return NULL;
+    }
+    pool->pinned = pinned;
+
+    pool->inject = mpmcRing_create(TPOOL_INJECT_CAP, sizeof(task*), NULL);
+    pool->workers = calloc(n_threads > 1 ? n_threads - 1 : 1, sizeof(tpool_worker));
+    if (GENVEC_UNLIKELY(!pool->inject || !pool->workers)) {
+        GENVEC_FAIL(GENVEC_ERR_ALLOC, "tpool create: malloc failed");
+        mpmcRing_destroy(pool->inject);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+
+    // every deque exists before any thread starts stealing from them
+    for (size_t i = 0; i + 1 < n_threads; i++) {
+        tpool_worker* w = &pool->workers[i];
+        if (deque_init(&w->deque) != 0) { break; }
+        w->pool = pool;
+        w->id = i + 1;
+        w->rng = (uint32_t)(i + 1) * 2654435761u;
+        pool->n_workers++;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    // a worker that fails to start just makes the pool smaller, its deque stays empty
+    for (size_t i = 0; i < pool->n_workers; i++) {
+        if (pthread_create(&pool->workers[i].thread, NULL, tpool_worker_main, &pool->workers[i]) != 0) { break; }
+        pool->n_started++;
+    }
+
+    return pool;
+}
+
+
+ThreadPool* tpool_create(size_t n_threads) {
+    return tpool_make(n_threads, 0);
+}
+
+ThreadPool* tpool_create_pinned(size_t n_threads) {
+    return tpool_make(n_threads, 1);
+}
+
+void tpool_destroy(ThreadPool* pool)
+{
+    if (!pool) { return; }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->n_started; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    for (size_t i = 0; i < pool->n_workers; i++) {
+        genVec_deinit(&pool->workers[i].deque.slots);
+    }
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    mpmcRing_destroy(pool->inject);
+    free(pool->workers);
+    free(pool);
+}
+
+size_t tpool_size(const ThreadPool* pool) {
+    return pool ? pool->n_started + 1 : 1;
+}
+
+ThreadPool* tpool_default(void)
+{
+    ThreadPool* pool = __atomic_load_n(&tpool_shared, __ATOMIC_ACQUIRE);
+    if (GENVEC_LIKELY(pool)) { return pool; }
+
+    pthread_mutex_lock(&tpool_shared_lock);
+    if (!tpool_shared) { __atomic_store_n(&tpool_shared, tpool_make(0, 0), __ATOMIC_RELEASE); }
+    pool = tpool_shared;
+    pthread_mutex_unlock(&tpool_shared_lock);
+    return pool;
+}
+
+int tpool_init_default(size_t n_threads, int pinned)
+{
+    pthread_mutex_lock(&tpool_shared_lock);
+    if (GENVEC_UNLIKELY(tpool_shared)) {
+        pthread_mutex_unlock(&tpool_shared_lock);
+        GENVEC_FAIL(GENVEC_ERR_INVALID, "tpool init default: default pool already exists");
+        return -1;
+    }
+
+    ThreadPool* pool = tpool_make(n_threads, pinned);
+    __atomic_store_n(&tpool_shared, pool, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&tpool_shared_lock);
+    return pool ? 0 : -1;
+}
+
+void task_spawn(ThreadPool* pool, taskGroup* group, task* t, task_fn fn, void* arg)
+{
+    if (GENVEC_UNLIKELY(!group || !t || !fn)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "task spawn: group, task or fn is null");
+        return;
+    }
+
+    t->fn = fn;
+    t->arg = arg;
+    t->group = group;
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+
+    if (!pool || pool->n_started == 0) {
+        tpool_run(t);
+        return;
+    }
+
+    tpool_worker* self = tpool_self;
+    int queued = (self && self->pool == pool) ? deque_push(&self->deque, t)
+                                              : mpmcRing_push(pool->inject, (const u8*)&t);
+    if (queued != 0) {
+        tpool_run(t);
+        return;
+    }
+    tpool_notify(pool);
+}
+
+void task_wait(ThreadPool* pool, taskGroup* group)
+{
+    if (GENVEC_UNLIKELY(!group)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "task wait: group is null");
+        return;
+    }
+
+    tpool_worker* self = (tpool_self && tpool_self->pool == pool) ? tpool_self : NULL;
+
+    // help out instead of blocking, whatever we run may be what we wait on. A
+    // thread without a deque only helps one level deep: its own spawns go to the
+    // injection queue, which it would pop back oldest first and recurse on forever
+    int help = pool && (self || !tpool_helping);
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) != 0) {
+        task* t = help ? tpool_find(pool, self) : NULL;
+        if (!t) {
+            sched_yield();
+            continue;
+        }
+        if (self) {
+            tpool_run(t);
+        } else {
+            tpool_helping = 1;
+            tpool_run(t);
+            tpool_helping = 0;
+        }
+    }
+}
+
+
+// parallel_for: every range keeps peeling its upper half off as a task and runs
+// what's left, so thieves always get the biggest piece still around
+
+typedef struct {
+    ThreadPool* pool;
+    tpool_range_fn fn;
+    void* ctx;
+    size_t grain;       // ranges up to this long aren't split again
+} tpool_for;
+
+typedef struct {
+    const tpool_for* loop;
+    size_t from, to;
+} tpool_range;
+
+static void tpool_for_range(void* arg)
+{
+    const tpool_range* r = arg;
+    const tpool_for* loop = r->loop;
+    size_t from = r->from;
+    size_t to = r->to;
+
+    // halving, so 64 halves are enough for any size_t range
+    task tasks[64];
+    tpool_range halves[64];
+    size_t k = 0;
+
+    taskGroup group;
+    task_group_init(&group);
+    while (to - from > loop->grain && k < 64) {
+        size_t mid = from + ((to - from) / 2);
+        halves[k] = (tpool_range){ loop, mid, to };
+        task_spawn(loop->pool, &group, &tasks[k], tpool_for_range, &halves[k]);
+        k++;
+        to = mid;
+    }
+
+    for (size_t i = from; i < to; i++) { loop->fn(loop->ctx, i); }
+    task_wait(loop->pool, &group);
+}
+
+void tpool_parallel_for(ThreadPool* pool, size_t n, size_t max_pieces, tpool_range_fn fn, void* ctx)
+{
+    if (GENVEC_UNLIKELY(!fn)) {
+        GENVEC_FAIL(GENVEC_ERR_NULL, "tpool parallel for: fn is null");
+        return;
+    }
+    if (n == 0) { return; }
+
+    size_t pieces = (max_pieces == 0 || max_pieces > n) ? n : max_pieces;
+    if (!pool || pool->n_started == 0 || pieces == 1) {
+        for (size_t i = 0; i < n; i++) { fn(ctx, i); }
+        return;
+    }
+
+    tpool_for loop = { pool, fn, ctx, (n + pieces - 1) / pieces };
+    tpool_range all = { &loop, 0, n };
+    tpool_for_range(&all);
+}
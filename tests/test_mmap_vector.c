@@ -0,0 +1,112 @@
+#include "mmap_vector.h"
+#include "genvec_error.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+// plain assert is gone under NDEBUG, this one isn't
+#define CHECK(cond) do {                                                    \
+    if (!(cond)) {                                                          \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                            \
+    }                                                                       \
+} while (0)
+
+#define N_ELMS 5000
+#define PATH   "test_mmap_vector.bin"
+
+
+static int cmp_desc(const u8* a, const u8* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x < y) - (x > y);
+}
+
+static uint64_t get_u64(genVec* vec, size_t i)
+{
+    uint64_t v = 0;
+    genVec_get(vec, i, (u8*)&v);
+    return v;
+}
+
+// push through the genVec API, then copies and sharing must fail without touching the file
+static void test_rdwr(void)
+{
+    mmapVec* mv = mmapVec_open(PATH, sizeof(uint64_t), MMAPVEC_RDWR | MMAPVEC_TRUNC);
+    CHECK(mv);
+    genVec* vec = mmapVec_vec(mv);
+
+    // even an empty mapped vec can't be copied, the copy's header would land in the file
+    CHECK(genVec_copy(vec) == NULL);
+    CHECK(genVec_last_error() == GENVEC_ERR_INVALID);
+
+    for (uint64_t i = 0; i < N_ELMS; i++) { CHECK(genVec_push(vec, (const u8*)&i) == 0); }
+    size_t map_size = mv->map_size;
+
+    CHECK(genVec_copy(vec) == NULL);
+    CHECK(genVec_last_error() == GENVEC_ERR_INVALID);
+    CHECK(genVec_share(vec) == -1);
+    CHECK(genVec_last_error() == GENVEC_ERR_INVALID);
+    CHECK(mv->map_size == map_size);
+    CHECK(get_u64(vec, N_ELMS - 1) == N_ELMS - 1);
+
+    // the sort's temp buffer must not come from the file either
+    genVec_stable_sort(vec, cmp_desc);
+    CHECK(mv->map_size == map_size);
+    genVec_stable_sort(vec, cmp_desc);
+
+    // copies go into a heap vec
+    genVec* heap = genVec_init(0, sizeof(uint64_t), NULL);
+    CHECK(genVec_assign(heap, vec) == 0);
+    CHECK(genVec_size(heap) == N_ELMS);
+    CHECK(get_u64(heap, 0) == N_ELMS - 1);
+    genVec_destroy(heap);
+
+    mmapVec_close(mv);
+}
+
+// in place edits work on a read only vec but stay in the process, growing fails with INVALID
+static void test_rdonly(void)
+{
+    mmapVec* ro = mmapVec_open(PATH, sizeof(uint64_t), MMAPVEC_RDONLY);
+    CHECK(ro);
+    genVec* vec = mmapVec_vec(ro);
+    CHECK(genVec_size(vec) == N_ELMS);
+
+    uint64_t v = 42;
+    genVec_clear_error();
+    CHECK(genVec_push(vec, (const u8*)&v) == -1);
+    CHECK(genVec_last_error() == GENVEC_ERR_INVALID);
+    CHECK(genVec_reserve(vec, N_ELMS * 2) == -1);
+    CHECK(genVec_last_error() == GENVEC_ERR_INVALID);
+    CHECK(genVec_size(vec) == N_ELMS);
+
+    CHECK(genVec_replace(vec, 0, (const u8*)&v) == 0);
+    CHECK(get_u64(vec, 0) == 42);
+    CHECK(genVec_remove(vec, 1) == 0);
+    genVec_sort(vec, cmp_desc);
+    CHECK(get_u64(vec, 0) == N_ELMS - 3);
+    mmapVec_close(ro);
+
+    // the file still holds what the writer left
+    ro = mmapVec_open(PATH, sizeof(uint64_t), MMAPVEC_RDONLY);
+    CHECK(ro);
+    vec = mmapVec_vec(ro);
+    CHECK(genVec_size(vec) == N_ELMS);
+    CHECK(get_u64(vec, 0) == N_ELMS - 1);
+    CHECK(get_u64(vec, 1) == N_ELMS - 2);
+    mmapVec_close(ro);
+}
+
+
+int main(void)
+{
+    test_rdwr();
+    test_rdonly();
+    remove(PATH);
+    printf("mmap_vector: ok\n");
+    return 0;
+}